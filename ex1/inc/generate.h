@@ -2,7 +2,24 @@
 #define _generate_h_
 
 #include <stddef.h> /* defines size_t */
+#include <stdint.h>
 
-long long *generate_random_poly(size_t n, size_t max_coeff);
+/* Counter-based generator: coefficient i is a pure function of (seed, i), so the polynomial
+is the same for every THREAD_COUNT and on every machine. Coefficients are non-zero integers
+in [-max_coeff, max_coeff]. Different seeds give independent polynomials. */
+long long *generate_random_poly(size_t n, size_t max_coeff, uint64_t seed, int thread_count);
+
+/* Zeroes every coefficient of POLY (degree n) except a DENSITY fraction of them, chosen with the same
+counter-based generator (so again independent of THREAD_COUNT). The leading coefficient is always kept,
+so the degree does not change. */
+void sparsify_poly(long long *poly, size_t n, double density, uint64_t seed, int thread_count);
+
+/* Output I of another stream of the same generator, mapped to [0, BOUND): for the other random choices of a run
+(such as batch degrees), so that they also depend on SEED only. */
+uint64_t random_below(uint64_t seed, uint64_t i, uint64_t bound);
+
+/* Seed I derived from SEED, for runs that generate several polynomials: the derived seeds of nearby SEEDs
+(S and S+1, ...) share no polynomial, and none of them is SEED itself. */
+uint64_t derive_seed(uint64_t seed, uint64_t i);
 
 #endif
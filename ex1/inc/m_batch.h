@@ -0,0 +1,25 @@
+#ifndef _m_batch_h_
+#define _m_batch_h_
+
+#include <stddef.h> /* defines size_t */
+
+/* One independent multiplication of a batch: A (degree n) times B (degree m).
+The product (n+m+1 coefficients) is written to arena[offset]. */
+struct poly_job {
+    const long long *A;
+    size_t n;
+    const long long *B;
+    size_t m;
+    size_t offset;
+};
+
+/* Assigns consecutive, non-overlapping offsets to the COUNT jobs and returns the number of
+long long elements the output arena must hold. */
+size_t m_batch_layout(struct poly_job *jobs, size_t count);
+
+/* Multiplies every job into ARENA, laid out by m_batch_layout.
+Jobs are handed out dynamically to THREAD_COUNT threads, most expensive (n*m) first, and each thread
+reuses one scratch buffer for all of its jobs. Parallelism is across jobs, each product is computed serially. */
+void m_batch(const struct poly_job *jobs, size_t count, long long *arena, size_t thread_count, double *time);
+
+#endif
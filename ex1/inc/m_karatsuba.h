@@ -0,0 +1,33 @@
+#ifndef _m_karatsuba_h_
+#define _m_karatsuba_h_
+
+#include <stddef.h> /* defines size_t */
+
+/* Divide-and-conquer polynomial multipliers: Karatsuba (Toom-2) and Toom-Cook 3-way.
+Operands of length <= THRESHOLD fall back to the schoolbook kernel (m_serial_kernel).
+Toom-3 recurses into Karatsuba once operands get shorter than TOOM3_RATIO * THRESHOLD.
+If THRESHOLD is 0, KARATSUBA_DEFAULT_THRESHOLD is used instead. */
+#define KARATSUBA_DEFAULT_THRESHOLD 32
+#define TOOM3_RATIO 16
+
+/* Karatsuba product of two length-LEN coefficient arrays. Writes 2*LEN-1 coefficients to R. */
+void karatsuba_mult(const long long *a, const long long *b, size_t len, long long *r, size_t threshold);
+
+long long *m_karatsuba(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, double *time);
+
+/* Same as m_karatsuba but the recursion is run with OpenMP tasks on THREAD_COUNT threads. */
+long long *m_karatsuba_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, size_t thread_count, double *time);
+
+/* Karatsuba only adds, subtracts and multiplies: like the schoolbook kernel, its result is exact modulo 2^64 even when
+intermediate values wrap. Toom-3 divides by 2 and 3 during interpolation, so its intermediate values, up to about
+len * 49^levels * maxA * maxB, must not wrap. Returns 1 if they stay below 2^62 for these operands (O(n + m) scan). */
+int toom3_exact(const long long *A, size_t n, const long long *B, size_t m, size_t threshold);
+
+/* Toom-3 product. If toom3_exact does not hold, the operands are multiplied with Karatsuba instead, so the result is
+always the one of the schoolbook kernel. */
+long long *m_toom3(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, double *time);
+
+/* Same as m_toom3 but the recursion is run with OpenMP tasks on THREAD_COUNT threads. */
+long long *m_toom3_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, size_t thread_count, double *time);
+
+#endif
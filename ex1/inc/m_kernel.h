@@ -0,0 +1,35 @@
+#ifndef _m_kernel_h_
+#define _m_kernel_h_
+
+#include <stddef.h> /* defines size_t */
+
+/* Rows of A per tile of the blocked schoolbook kernel. A tile and the window of B it meets
+(about 2*TILE coefficients, 16 KB for 64-bit coefficients) stay in L1 while its outputs are computed. */
+#define M_KERNEL_TILE 1024
+
+/* Consecutive outputs kept in registers by the kernel */
+#define M_KERNEL_BLOCK 32
+
+/* Scratch elements m_kernel_tiled_buf needs for a B of degree M (B zero-padded by a block on each side) */
+#define M_KERNEL_SCRATCH(m) ((m) + 1 + 2*M_KERNEL_BLOCK)
+
+/* Cache-blocked schoolbook kernel: accumulates the product of A (degree n) and B (degree m) into R.
+R must hold n+m+1 elements. Outputs are computed 32 at a time in registers over a tile of A, with
+AVX-512, AVX2 or scalar code picked at run time. */
+void m_kernel_tiled(const long long *A, size_t n, const long long *B, size_t m, long long *R);
+
+/* Same as m_kernel_tiled, using the caller's SCRATCH of at least M_KERNEL_SCRATCH(m) elements instead of allocating. */
+void m_kernel_tiled_buf(const long long *A, size_t n, const long long *B, size_t m, long long *R, long long *scratch);
+
+/* Copies B (degree M) into SCRATCH, of at least M_KERNEL_SCRATCH(m) elements, with the zero padding the kernel needs.
+Returns the padded B to pass to m_kernel_range. */
+const long long *m_kernel_pad(const long long *B, size_t m, long long *scratch);
+
+/* Accumulates only the outputs k in [k0, k1) of the product of A (degree n) and B (degree m) into R[k - k0].
+BZ is B padded by m_kernel_pad; it can be shared by concurrent calls. */
+void m_kernel_range(const long long *A, size_t n, const long long *Bz, size_t m, size_t k0, size_t k1, long long *R);
+
+/* Name of the instruction set used by m_kernel_tiled on this CPU: "avx512", "avx2" or "scalar". */
+const char *m_kernel_isa(void);
+
+#endif
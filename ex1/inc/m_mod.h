@@ -0,0 +1,23 @@
+#ifndef _m_mod_h_
+#define _m_mod_h_
+
+#include <stddef.h> /* defines size_t */
+#include <stdint.h>
+
+/* Largest supported modulus: residues and their sums must fit a long long */
+#define MOD_MAX ((uint64_t) INT64_MAX)
+
+/* Multiplication in Z_p[x]: R[k] = sum A[i]*B[k-i] mod P, returned in [0, P) for 2 <= P <= MOD_MAX.
+Negative coefficients are reduced first, so the result is exact whatever the degree and coefficient size.
+Every product is reduced in the kernel: Barrett for P < 2^32, Montgomery (R = 2^64) for larger odd P,
+and a 128-bit division for larger even P. */
+long long *m_mod(const long long *A, size_t n, const long long *B, size_t m, uint64_t p, double *time);
+
+/* Same as m_mod, with the decomposition of m_parallel: blocks of rows of A are multiplied into private
+per-thread buffers, which are then summed mod P over contiguous output ranges (an atomic cannot reduce mod P). */
+long long *m_mod_parallel(const long long *A, size_t n, const long long *B, size_t m, uint64_t p, size_t thread_count, double *time);
+
+/* Name of the reduction m_mod uses for P: "barrett", "montgomery" or "div128". */
+const char *m_mod_reduction(uint64_t p);
+
+#endif
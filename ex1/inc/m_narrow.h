@@ -0,0 +1,21 @@
+#ifndef _m_narrow_h_
+#define _m_narrow_h_
+
+#include <stddef.h> /* defines size_t */
+
+/* Narrow-coefficient multiplication for small-magnitude polynomials.
+The maximum absolute coefficient of each operand is scanned (O(n + m)) and raised to BOUND if smaller: BOUND can only
+widen the types, so a bound below the actual coefficients never truncates them (0: the scan alone).
+The inputs are packed into int8/int16/int32 arrays, the smallest type that holds both maxima, and the products are
+accumulated in int32 when (min(n,m)+1) * boundA * boundB fits, int64 otherwise. The result is returned as long long.
+Operands that need 64-bit coefficients are multiplied with the regular kernel (m_kernel_tiled, or m_parallel in m_narrow_parallel). */
+
+/* Returns the input width in bits (8, 16, 32 or 64) that the narrow path would use, and sets ACC_BITS to the accumulator width. */
+int m_narrow_plan(const long long *A, size_t n, const long long *B, size_t m, long long bound, int *acc_bits);
+
+long long *m_narrow(const long long *A, size_t n, const long long *B, size_t m, long long bound, double *time);
+
+/* Same as m_narrow, with the output blocks shared among THREAD_COUNT threads. */
+long long *m_narrow_parallel(const long long *A, size_t n, const long long *B, size_t m, long long bound, size_t thread_count, double *time);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _m_ntt_h_
+#define _m_ntt_h_
+
+#include <stddef.h> /* defines size_t */
+
+/* Exact polynomial multiplication with the number-theoretic transform.
+The product is computed modulo NTT-friendly primes below 2^31 and reconstructed with the CRT. The number of primes
+(3 to NTT_MAX_PRIMES) is chosen from an O(n + m) scan of the coefficients so that the product M of the primes exceeds
+2 * (min(n,m)+1) * max|A| * max|B|: the result is then bit-exact against m_serial (coefficients that overflow long long
+wrap exactly like the schoolbook loop). 3 primes cover results below ~2^89, 5 cover any 63-bit inputs.
+Transform length is limited to 2^NTT_MAX_LOG, i.e. n+m+1 <= 2^26, with 3 primes, and to 2^25 with more. */
+#define NTT_MAX_LOG 26
+#define NTT_MAX_PRIMES 6
+
+/* Returns the number of primes m_ntt uses for these operands, 0 if even NTT_MAX_PRIMES are not enough. */
+int m_ntt_primes(const long long *A, size_t n, const long long *B, size_t m);
+
+/* Exits with an error if the product is too large for an exact result (see m_ntt_primes) or the transform too long. */
+long long *m_ntt(const long long *A, size_t n, const long long *B, size_t m, double *time);
+
+/* Same as m_ntt, but every butterfly stage, the pointwise product and the CRT are split among THREAD_COUNT threads. */
+long long *m_ntt_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time);
+
+#endif
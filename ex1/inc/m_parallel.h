@@ -5,4 +5,19 @@
 
 long long *m_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t num_threads, double *time);
 
+/* Output-partitioned parallel multiplication: each thread computes a contiguous range of result coefficients
+R[k] = sum A[i]*B[k-i] directly. Ranges are balanced by multiply-add count, and no private buffers or atomics are used. */
+long long *m_parallel_outpart(const long long *A, size_t n, const long long *B, size_t m, size_t num_threads, double *time);
+
+/* Receives the next COUNT result coefficients of a streaming multiplication, in order */
+typedef void (*m_sink)(const long long *R, size_t count, void *ctx);
+
+/* Result coefficients finalized per call of the sink by m_parallel_stream */
+#define M_STREAM_CHUNK 65536
+
+/* Output-partitioned multiplication that hands the result to SINK in chunks of M_STREAM_CHUNK coefficients
+as soon as each chunk is complete, instead of returning it: memory is two chunks whatever the degree.
+SINK runs on one thread while the others compute the next chunk. */
+void m_parallel_stream(const long long *A, size_t n, const long long *B, size_t m, size_t num_threads, m_sink sink, void *ctx, double *time);
+
 #endif
\ No newline at end of file
@@ -3,6 +3,11 @@
 
 #include <stddef.h> /* defines size_t */
 
+/* Schoolbook kernel: accumulates the product of A (degree n) and B (degree m) into R.
+R must hold n+m+1 elements. Used as the base case of the divide-and-conquer multipliers.
+Runs the cache-blocked, SIMD kernel of m_kernel.h. */
+void m_serial_kernel(const long long *A, size_t n, const long long *B, size_t m, long long *R);
+
 long long *m_serial(const long long *A, size_t n, const long long *B, size_t m, double *time);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef _m_sparse_h_
+#define _m_sparse_h_
+
+#include <stddef.h> /* defines size_t */
+
+/* Sparse polynomial: NTERMS non-zero terms coeff[t] * x^exp[t], with exponents strictly increasing.
+Memory scales with the number of terms instead of the degree. */
+struct sparse_poly {
+    size_t nterms;
+    size_t *exp;
+    long long *coeff;
+};
+
+/* Returns an empty sparse_poly: nterms set to 0 and pointer fields to NULL. */
+struct sparse_poly init_sparse_poly(void);
+
+/* Builds the sparse representation of the dense polynomial P of degree n (zero coefficients are skipped). */
+struct sparse_poly sparse_poly_from_dense(const long long *P, size_t n);
+
+/* Allocates and returns the dense coefficient array (degree+1 elements, zero-filled) of P.
+DEGREE must be at least the largest exponent of P. */
+long long *sparse_poly_to_dense(const struct sparse_poly *P, size_t degree);
+
+/* Frees the arrays of P and resets it to empty. */
+void free_sparse_poly(struct sparse_poly *P);
+
+/* Product of two sparse polynomials with a binary heap over the terms of the shorter operand (Johnson's algorithm):
+O(na*nb*log(min(na,nb))) time, output produced in exponent order, so no dense accumulator is needed.
+Terms that cancel out are dropped. */
+struct sparse_poly m_sparse(const struct sparse_poly *A, const struct sparse_poly *B, double *time);
+
+/* Same as m_sparse, with the terms of the shorter operand split among THREAD_COUNT threads. Every thread
+builds a sorted partial product, then the partial products are merged pairwise in parallel. */
+struct sparse_poly m_sparse_parallel(const struct sparse_poly *A, const struct sparse_poly *B, size_t thread_count, double *time);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef _m_wide_h_
+#define _m_wide_h_
+
+#include <stddef.h> /* defines size_t */
+
+/* Schoolbook multiplication with 128-bit accumulation: products of long long coefficients are exact in
+__int128, so the result is exact as long as (min(n,m)+1) * max|A| * max|B| < 2^127, i.e. for any coefficients
+below 2^31 in magnitude up to degree 2^64, or full 64-bit coefficients over short overlaps. */
+__int128 *m_wide(const long long *A, size_t n, const long long *B, size_t m, double *time);
+
+/* Same as m_wide, with the decomposition of m_parallel: blocks of rows of A are multiplied into private
+per-thread buffers, which are then summed over contiguous output ranges (there is no 128-bit atomic add). */
+__int128 *m_wide_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef _poly_io_h_
+#define _poly_io_h_
+
+#include <stddef.h> /* defines size_t */
+#include <stdint.h>
+#include <stdio.h>
+
+/* Binary polynomial file: a 16-byte header followed by the degree+1 coefficients, lowest degree first,
+as little-endian two's complement integers of WIDTH bytes (1, 2, 4, 8, or 16 for 128-bit results).
+The header size keeps the coefficients 8-byte aligned in a mapping of the file. */
+#define POLY_MAGIC "POLY"
+
+struct poly_header {
+    char magic[4];
+    uint32_t width;
+    uint64_t degree;
+};
+
+/* A polynomial file mapped in memory */
+struct poly_map {
+    const long long *coeffs; /* degree+1 coefficients */
+    size_t degree;
+    int width;
+    void *base;              /* the mapping */
+    size_t length;
+    long long *widened;      /* owned copy of the coefficients if width < 8, NULL otherwise */
+};
+
+/* Maps the file at PATH read-only. With 8-byte coefficients COEFFS points into the mapping itself (no copy,
+pages are only faulted in when a multiplier reads them); narrower coefficients are widened to long long by
+THREAD_COUNT threads. 16-byte files cannot be used as inputs. Exits on any error. */
+void poly_map_open(const char *path, int thread_count, struct poly_map *pm);
+
+/* Unmaps the file and frees the widened copy, if any */
+void poly_map_close(struct poly_map *pm);
+
+/* Streaming writer: coefficients are appended in order, in as many calls as convenient */
+struct poly_writer {
+    FILE *file;
+    const char *path;
+    int width;
+    size_t degree;
+    size_t written;
+    unsigned char *buf; /* packing buffer for widths other than 8 */
+};
+
+/* Smallest width (1, 2, 4 or 8 bytes) holding every value in [-bound, bound] */
+int poly_width_for(long long bound);
+
+/* Creates PATH and writes the header of a polynomial of degree DEGREE with WIDTH-byte coefficients. Exits on error. */
+void poly_writer_open(struct poly_writer *w, const char *path, size_t degree, int width);
+
+/* Appends the next COUNT coefficients. Exits if a value does not fit the width. */
+void poly_writer_append(struct poly_writer *w, const long long *coeffs, size_t count);
+void poly_writer_append_wide(struct poly_writer *w, const __int128 *coeffs, size_t count);
+
+/* Closes the file; exits if fewer or more than degree+1 coefficients were written */
+void poly_writer_close(struct poly_writer *w);
+
+#endif
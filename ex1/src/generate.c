@@ -1,20 +1,61 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 
-long long *generate_random_poly(size_t n, size_t max_coeff){
+#include "generate.h"
+
+/* SplitMix64 finalizer (Steele, Lea, Flood): a bijective 64-bit mix with full avalanche */
+static inline uint64_t splitmix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+#define GOLDEN_GAMMA 0x9e3779b97f4a7c15ULL /* SplitMix64 state increment */
+
+long long *generate_random_poly(size_t n, size_t max_coeff, uint64_t seed, int thread_count){
     long long *poly = malloc((size_t)(n+1) * sizeof(long long));
     if (!poly) {
         perror("malloc poly");
         exit(EXIT_FAILURE);
     }
+    if (thread_count < 1) thread_count = 1;
 
+    uint64_t state = splitmix64(seed); /* start of this polynomial's stream */
+    uint64_t range = 2 * (uint64_t) max_coeff; /* number of non-zero values in [-max_coeff, max_coeff] */
+
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
     for (size_t i = 0; i <= n; i++){
-        int coeff;
-        do {
-        coeff = (rand() % (2*max_coeff + 1)) - max_coeff; /* in range [-max_coeff, max_coeff] */
-        } while (coeff == 0); /* coefficients should be non-zero integers */
-        poly[i] = (long long) coeff;
+        uint64_t h = splitmix64(state + (uint64_t)(i + 1) * GOLDEN_GAMMA); /* i-th output of the SplitMix64 sequence */
+        /* Map to [0, range) with a multiply-high, then skip 0: coefficients should be non-zero integers */
+        long long coeff = (long long)(((unsigned __int128) h * range) >> 64) - (long long) max_coeff;
+        poly[i] = coeff >= 0 ? coeff + 1 : coeff;
     }
 
     return poly;
-}
\ No newline at end of file
+}
+
+void sparsify_poly(long long *poly, size_t n, double density, uint64_t seed, int thread_count){
+    if (density >= 1.0) return;
+    if (thread_count < 1) thread_count = 1;
+
+    uint64_t state = splitmix64(~seed); /* stream distinct from the coefficient one */
+    uint64_t keep = density <= 0.0 ? 0 : (uint64_t)(density * 18446744073709551616.0); /* density * 2^64 */
+
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (size_t i = 0; i < n; i++){
+        if (splitmix64(state + (uint64_t)(i + 1) * GOLDEN_GAMMA) >= keep)
+            poly[i] = 0;
+    }
+}
+
+uint64_t random_below(uint64_t seed, uint64_t i, uint64_t bound) {
+    uint64_t state = splitmix64(seed ^ 0xd1b54a32d192ed03ULL); /* stream distinct from the two above */
+    uint64_t h = splitmix64(state + (i + 1) * GOLDEN_GAMMA);
+    return (uint64_t) (((unsigned __int128) h * bound) >> 64);
+}
+
+uint64_t derive_seed(uint64_t seed, uint64_t i) {
+    uint64_t state = splitmix64(seed ^ 0x8cb92ba72f3d8dd7ULL); /* yet another stream */
+    return splitmix64(state + (i + 1) * GOLDEN_GAMMA);
+}
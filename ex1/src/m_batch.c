@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_batch.h"
+#include "m_kernel.h"
+
+size_t m_batch_layout(struct poly_job *jobs, size_t count) {
+    size_t total = 0;
+    for (size_t j = 0; j < count; j++) {
+        jobs[j].offset = total;
+        total += jobs[j].n + jobs[j].m + 1;
+    }
+    return total;
+}
+
+/* Job index and its estimated cost, for sorting */
+struct job_cost {
+    size_t idx;
+    size_t cost;
+};
+
+static int cmp_cost_desc(const void *a, const void *b) {
+    size_t ca = ((const struct job_cost *) a)->cost;
+    size_t cb = ((const struct job_cost *) b)->cost;
+    return (ca < cb) - (ca > cb);
+}
+
+void m_batch(const struct poly_job *jobs, size_t count, long long *arena, size_t thread_count, double *time) {
+    struct timespec start, end;
+
+    /* Longest jobs first, so that the last jobs handed out are the short ones and threads finish together */
+    struct job_cost *order = malloc(count * sizeof(*order));
+    if (!order) {
+        perror("malloc order");
+        exit(EXIT_FAILURE);
+    }
+    size_t max_m = 0;
+    for (size_t j = 0; j < count; j++) {
+        order[j].idx  = j;
+        order[j].cost = (jobs[j].n + 1) * (jobs[j].m + 1);
+        if (jobs[j].m > max_m) max_m = jobs[j].m;
+    }
+    qsort(order, count, sizeof(*order), cmp_cost_desc);
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Per-thread scratch, sized for the largest job and reused by all of this thread's jobs */
+        long long *scratch = malloc(M_KERNEL_SCRATCH(max_m) * sizeof(long long));
+        if (!scratch) {
+            perror("malloc scratch");
+            exit(EXIT_FAILURE);
+        }
+
+        # pragma omp for schedule(dynamic, 1)
+        for (size_t t = 0; t < count; t++) {
+            const struct poly_job *job = &jobs[order[t].idx];
+            long long *R = &arena[job->offset];
+            memset(R, 0, (job->n + job->m + 1) * sizeof(long long)); /* no other job writes this range */
+            m_kernel_tiled_buf(job->A, job->n, job->B, job->m, R, scratch);
+        }
+
+        free(scratch);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(order);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+}
@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_karatsuba.h"
+#include "m_serial.h" /* for the schoolbook base case */
+
+/* Signature shared by the recursions. Writes 2*LEN-1 coefficients to R. Operands longer than CUTOFF are split into
+tasks, shorter ones are multiplied serially inside a single task (SIZE_MAX: fully serial, no parallel region needed). */
+typedef void (*square_mult_fn)(const long long *a, const long long *b, size_t len, long long *r, size_t threshold, size_t cutoff);
+
+/* Karatsuba only adds, subtracts and multiplies, so it is exact modulo 2^64 like the schoolbook kernel,
+provided that the sums wrap instead of overflowing (signed overflow is undefined). */
+static inline long long add_wrap(long long x, long long y) {
+    return (long long) ((unsigned long long) x + (unsigned long long) y);
+}
+
+static inline long long sub_wrap(long long x, long long y) {
+    return (long long) ((unsigned long long) x - (unsigned long long) y);
+}
+
+static void *xmalloc(size_t count, const char *what) {
+    void *p = malloc(count * sizeof(long long));
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/*------------------------------------ Karatsuba ------------------------------------*/
+
+/* Number of scratch elements needed by kara_rec for operands of length LEN */
+static size_t kara_scratch_size(size_t len, size_t threshold) {
+    size_t size = 0;
+    while (len > threshold) {
+        size_t hh = len - len/2;
+        size += 4*hh; /* sa, sb and the middle product of each level */
+        len = hh;
+    }
+    return size;
+}
+
+/* Serial Karatsuba recursion. SCRATCH holds at least kara_scratch_size(LEN) elements. */
+static void kara_rec(const long long *a, const long long *b, size_t len, long long *r, size_t threshold, long long *scratch) {
+    if (len <= threshold) {
+        memset(r, 0, (2*len - 1) * sizeof(long long));
+        m_serial_kernel(a, len-1, b, len-1, r);
+        return;
+    }
+
+    size_t h  = len/2;      /* length of the low halves */
+    size_t hh = len - h;    /* length of the high halves, hh >= h */
+    long long *sa = scratch, *sb = sa + hh, *z1 = sb + hh, *next = z1 + 2*hh;
+
+    kara_rec(a,     b,     h,  r,       threshold, next); /* z0 = a0*b0 in r[0 .. 2h-2] */
+    r[2*h - 1] = 0;
+    kara_rec(a + h, b + h, hh, r + 2*h, threshold, next); /* z2 = a1*b1 in r[2h .. 2len-2] */
+
+    for (size_t i = 0; i < h; i++) {
+        sa[i] = add_wrap(a[i], a[h+i]);
+        sb[i] = add_wrap(b[i], b[h+i]);
+    }
+    if (hh > h) { /* odd length: the high half has one extra coefficient */
+        sa[h] = a[2*h];
+        sb[h] = b[2*h];
+    }
+    kara_rec(sa, sb, hh, z1, threshold, next); /* (a0+a1)*(b0+b1) */
+
+    /* z1 = (a0+a1)*(b0+b1) - z0 - z2 */
+    for (size_t i = 0; i < 2*h - 1; i++)
+        z1[i] = sub_wrap(z1[i], r[i]);
+    for (size_t i = 0; i < 2*hh - 1; i++)
+        z1[i] = sub_wrap(z1[i], r[2*h + i]);
+    for (size_t i = 0; i < 2*hh - 1; i++)
+        r[h + i] = add_wrap(r[h + i], z1[i]);
+}
+
+void karatsuba_mult(const long long *a, const long long *b, size_t len, long long *r, size_t threshold) {
+    if (threshold < 1) threshold = KARATSUBA_DEFAULT_THRESHOLD;
+    long long *scratch = xmalloc(kara_scratch_size(len, threshold) + 1, "malloc karatsuba scratch");
+    kara_rec(a, b, len, r, threshold, scratch);
+    free(scratch);
+}
+
+/* Task-parallel Karatsuba recursion. Each of the three sub-products becomes a task with its own buffers. */
+static void kara_rec_parallel(const long long *a, const long long *b, size_t len, long long *r, size_t threshold, size_t cutoff) {
+    if (len <= cutoff || len <= threshold) {
+        karatsuba_mult(a, b, len, r, threshold);
+        return;
+    }
+
+    size_t h  = len/2;
+    size_t hh = len - h;
+    long long *sa = xmalloc(4*hh, "malloc karatsuba buffers");
+    long long *sb = sa + hh, *z1 = sb + hh;
+
+    for (size_t i = 0; i < h; i++) {
+        sa[i] = add_wrap(a[i], a[h+i]);
+        sb[i] = add_wrap(b[i], b[h+i]);
+    }
+    if (hh > h) {
+        sa[h] = a[2*h];
+        sb[h] = b[2*h];
+    }
+    r[2*h - 1] = 0;
+
+    # pragma omp task shared(a, b, r) firstprivate(h)
+    kara_rec_parallel(a, b, h, r, threshold, cutoff);
+
+    # pragma omp task shared(a, b, r) firstprivate(h, hh)
+    kara_rec_parallel(a + h, b + h, hh, r + 2*h, threshold, cutoff);
+
+    # pragma omp task shared(sa, sb, z1) firstprivate(hh)
+    kara_rec_parallel(sa, sb, hh, z1, threshold, cutoff);
+
+    # pragma omp taskwait
+    for (size_t i = 0; i < 2*h - 1; i++)
+        z1[i] = sub_wrap(z1[i], r[i]);
+    for (size_t i = 0; i < 2*hh - 1; i++)
+        z1[i] = sub_wrap(z1[i], r[2*h + i]);
+    for (size_t i = 0; i < 2*hh - 1; i++)
+        r[h + i] = add_wrap(r[h + i], z1[i]);
+
+    free(sa);
+}
+
+/*------------------------------------ Toom-Cook 3 ------------------------------------*/
+
+/* Toom-3 recursion, evaluation at 0, 1, -1, -2, inf with Bodrato's interpolation sequence.
+The five pointwise products are run as tasks when LEN is above CUTOFF. The exact divisions of the interpolation
+need the true values of the products: only called when toom3_exact holds. */
+static void toom3_rec(const long long *a, const long long *b, size_t len, long long *r, size_t threshold, size_t cutoff) {
+    if (len <= TOOM3_RATIO * threshold || len < 5) {
+        kara_rec_parallel(a, b, len, r, threshold, cutoff);
+        return;
+    }
+
+    size_t k  = (len + 2) / 3;  /* length of the three parts (the top one is zero-padded) */
+    size_t l2 = len - 2*k;      /* real length of the top part, 0 < l2 <= k */
+    const long long *a0 = a, *a1 = a + k, *a2 = a + 2*k;
+    const long long *b0 = b, *b1 = b + k, *b2 = b + 2*k;
+
+    /* Evaluations: 4 per operand (the value at 0 is a0/b0 itself), then 5 products of 2k-1 coefficients */
+    long long *buf = xmalloc(8*k + 5*(2*k - 1), "malloc toom3 buffers");
+    long long *pa1 = buf,       *pam1 = pa1 + k,  *pam2 = pam1 + k, *painf = pam2 + k;
+    long long *pb1 = painf + k, *pbm1 = pb1 + k,  *pbm2 = pbm1 + k, *pbinf = pbm2 + k;
+    long long *r0 = pbinf + k;
+    long long *r1 = r0 + (2*k - 1), *rm1 = r1 + (2*k - 1), *rm2 = rm1 + (2*k - 1), *rinf = rm2 + (2*k - 1);
+
+    for (size_t i = 0; i < k; i++) {
+        long long x2 = i < l2 ? a2[i] : 0;
+        long long y2 = i < l2 ? b2[i] : 0;
+        long long pa = a0[i] + x2, pb = b0[i] + y2;
+        pa1[i]   = pa + a1[i];
+        pam1[i]  = pa - a1[i];
+        pam2[i]  = (pam1[i] + x2) * 2 - a0[i];
+        painf[i] = x2;
+        pb1[i]   = pb + b1[i];
+        pbm1[i]  = pb - b1[i];
+        pbm2[i]  = (pbm1[i] + y2) * 2 - b0[i];
+        pbinf[i] = y2;
+    }
+
+    int task_enable = len > cutoff;
+
+    # pragma omp task if (task_enable) firstprivate(k)
+    toom3_rec(a0, b0, k, r0, threshold, cutoff);
+    # pragma omp task if (task_enable) firstprivate(k)
+    toom3_rec(pa1, pb1, k, r1, threshold, cutoff);
+    # pragma omp task if (task_enable) firstprivate(k)
+    toom3_rec(pam1, pbm1, k, rm1, threshold, cutoff);
+    # pragma omp task if (task_enable) firstprivate(k)
+    toom3_rec(pam2, pbm2, k, rm2, threshold, cutoff);
+    # pragma omp task if (task_enable) firstprivate(k)
+    toom3_rec(painf, pbinf, k, rinf, threshold, cutoff);
+    # pragma omp taskwait
+
+    /* Interpolation. Coefficients past 2*len-2 are known to be zero and are skipped. */
+    size_t rlen = 2*len - 1;
+    memset(r, 0, rlen * sizeof(long long));
+    for (size_t i = 0; i < 2*k - 1; i++) {
+        long long v0 = r0[i], vinf = rinf[i];
+        long long t3 = (rm2[i] - r1[i]) / 3;
+        long long t1 = (r1[i] - rm1[i]) / 2;
+        long long t2 = rm1[i] - v0;
+        t3 = (t2 - t3) / 2 + 2*vinf;
+        t2 = t2 + t1 - vinf;
+        t1 = t1 - t3;
+
+        r[i] += v0;
+        if (  k + i < rlen) r[  k + i] += t1;
+        if (2*k + i < rlen) r[2*k + i] += t2;
+        if (3*k + i < rlen) r[3*k + i] += t3;
+        if (4*k + i < rlen) r[4*k + i] += vinf;
+    }
+
+    free(buf);
+}
+
+/* Largest |X[i]| */
+static long double max_abs(const long long *X, size_t len) {
+    long double mx = 0;
+    for (size_t i = 0; i < len; i++) {
+        long double v = X[i] < 0 ? -(long double) X[i] : (long double) X[i];
+        if (v > mx) mx = v;
+    }
+    return mx;
+}
+
+int toom3_exact(const long long *A, size_t n, const long long *B, size_t m, size_t threshold) {
+    if (threshold < 1) threshold = KARATSUBA_DEFAULT_THRESHOLD;
+    /* The recursion sees blocks of the length of the shorter operand. Each level evaluates at -2 (|a0 - 2a1 + 4a2|
+    <= 7 max), so the products of level j have coefficients up to len_j * 49^j * maxA * maxB, and the interpolation
+    numerators up to 3 times that. */
+    size_t len = (n < m ? n : m) + 1;
+    long double scale = 1, worst = 0;
+    while (!(len <= TOOM3_RATIO * threshold || len < 5)) {
+        len = (len + 2) / 3;
+        scale *= 49;
+        if (3 * len * scale > worst) worst = 3 * len * scale;
+    }
+    if (worst == 0) return 1; /* no Toom-3 level: plain Karatsuba */
+    return worst * max_abs(A, n + 1) * max_abs(B, m + 1) < 0x1p62L;
+}
+
+/*------------------------------------ Drivers ------------------------------------*/
+
+/* Pick the operand length below which no more tasks are created, so that roughly
+8 tasks per thread are spawned. BRANCH is the number of sub-products per level and SPLIT the length divisor. */
+static size_t task_cutoff(size_t len, size_t threshold, size_t thread_count, size_t branch, size_t split) {
+    size_t avg_tasks_per_thread = 8;
+    size_t tasks = 1;
+    while (tasks < avg_tasks_per_thread * thread_count && len / split > threshold) {
+        len = (len + split - 1) / split;
+        tasks *= branch;
+    }
+    return len;
+}
+
+/* Multiply the longer operand block by block with the shorter one, so that the square recursions always see equal lengths. */
+static void mult_blocks(const long long *X, size_t lx, const long long *Y, size_t ly, long long *R, size_t threshold,
+                        size_t cutoff, square_mult_fn mult, long long *pad, long long *prod) {
+    for (size_t off = 0; off < lx; off += ly) {
+        size_t len = lx - off < ly ? lx - off : ly;
+        const long long *a = X + off;
+        if (len < ly) { /* last block: zero-pad to the length of Y */
+            memcpy(pad, a, len * sizeof(long long));
+            memset(pad + len, 0, (ly - len) * sizeof(long long));
+            a = pad;
+        }
+        mult(a, Y, ly, prod, threshold, cutoff);
+        for (size_t i = 0; i < len + ly - 1; i++)
+            R[off + i] = add_wrap(R[off + i], prod[i]);
+    }
+}
+
+/* Common entry point. THREAD_COUNT 0 runs serially, otherwise MULT is called inside a parallel region by a single thread. */
+static long long *m_blocked(const long long *A, size_t n, const long long *B, size_t m, size_t threshold,
+                            square_mult_fn mult, size_t thread_count, size_t branch, size_t split, double *time) {
+    struct timespec start, end;
+    size_t r = n + m + 1;
+
+    long long *R = calloc(r, sizeof(long long));
+    if (!R) {
+        perror("calloc R");
+        exit(EXIT_FAILURE);
+    }
+
+    /* X is the longer operand */
+    const long long *X = A, *Y = B;
+    size_t lx = n + 1, ly = m + 1;
+    if (lx < ly) {
+        X = B; Y = A;
+        lx = m + 1; ly = n + 1;
+    }
+
+    long long *pad  = xmalloc(ly, "malloc pad");
+    long long *prod = xmalloc(2*ly - 1, "malloc prod");
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    if (thread_count == 0) {
+        mult_blocks(X, lx, Y, ly, R, threshold, SIZE_MAX, mult, pad, prod);
+    } else {
+        size_t cutoff = task_cutoff(ly, threshold, thread_count, branch, split);
+        # pragma omp parallel num_threads(thread_count)
+        {
+            # pragma omp single
+            mult_blocks(X, lx, Y, ly, R, threshold, cutoff, mult, pad, prod);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(pad);
+    free(prod);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
+
+long long *m_karatsuba(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, double *time) {
+    if (threshold < 1) threshold = KARATSUBA_DEFAULT_THRESHOLD;
+    return m_blocked(A, n, B, m, threshold, kara_rec_parallel, 0, 3, 2, time);
+}
+
+long long *m_karatsuba_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, size_t thread_count, double *time) {
+    if (threshold < 1) threshold = KARATSUBA_DEFAULT_THRESHOLD;
+    return m_blocked(A, n, B, m, threshold, kara_rec_parallel, thread_count, 3, 2, time);
+}
+
+long long *m_toom3(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, double *time) {
+    if (threshold < 1) threshold = KARATSUBA_DEFAULT_THRESHOLD;
+    if (!toom3_exact(A, n, B, m, threshold))
+        return m_blocked(A, n, B, m, threshold, kara_rec_parallel, 0, 3, 2, time);
+    return m_blocked(A, n, B, m, threshold, toom3_rec, 0, 5, 3, time);
+}
+
+long long *m_toom3_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t threshold, size_t thread_count, double *time) {
+    if (threshold < 1) threshold = KARATSUBA_DEFAULT_THRESHOLD;
+    if (!toom3_exact(A, n, B, m, threshold))
+        return m_blocked(A, n, B, m, threshold, kara_rec_parallel, thread_count, 3, 2, time);
+    return m_blocked(A, n, B, m, threshold, toom3_rec, thread_count, 5, 3, time);
+}
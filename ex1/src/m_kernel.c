@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define M_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+#include "m_kernel.h"
+
+/* Number of consecutive outputs kept in registers by the inner kernel */
+#define BLOCK_W M_KERNEL_BLOCK
+
+/* Inner kernel of every variant, for l in [0, BLOCK_W):
+ *     r[l] += sum_{t=0}^{cnt-1} a[t] * b[l - t]
+ * b[l - t] must be readable for all such l and t (B is zero-padded by BLOCK_W on each side).
+ * The BLOCK_W outputs stay in registers for the whole t loop, so R is loaded and stored once per block. */
+typedef void (*block_fn)(long long *r, const long long *a, const long long *b, size_t cnt);
+
+static void block_scalar(long long *r, const long long *a, const long long *b, size_t cnt) {
+    long long acc[BLOCK_W];
+    memcpy(acc, r, sizeof(acc));
+    for (size_t t = 0; t < cnt; t++) {
+        long long at = a[t];
+        const long long *bt = b - t;
+        for (int l = 0; l < BLOCK_W; l++)
+            acc[l] += at * bt[l];
+    }
+    memcpy(r, acc, sizeof(acc));
+}
+
+#ifdef M_KERNEL_X86
+/* AVX2 has no 64-bit multiply, so x*y mod 2^64 is built from three 32x32->64 products:
+ * lo(x)*lo(y) + ((hi(x)*lo(y) + lo(x)*hi(y)) << 32). This is exact for signed values as well. */
+__attribute__((target("avx2")))
+static inline __m256i mullo_epi64_avx2(__m256i x, __m256i x_hi, __m256i y) {
+    __m256i lo    = _mm256_mul_epu32(x, y);
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(x_hi, y), _mm256_mul_epu32(x, _mm256_srli_epi64(y, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2")))
+static void block_avx2(long long *r, const long long *a, const long long *b, size_t cnt) {
+    __m256i acc[BLOCK_W/4];
+    for (int v = 0; v < BLOCK_W/4; v++)
+        acc[v] = _mm256_loadu_si256((const __m256i *) &r[4*v]);
+    for (size_t t = 0; t < cnt; t++) {
+        __m256i va    = _mm256_set1_epi64x(a[t]);
+        __m256i va_hi = _mm256_srli_epi64(va, 32);
+        const long long *bt = b - t;
+        for (int v = 0; v < BLOCK_W/4; v++) {
+            __m256i vb = _mm256_loadu_si256((const __m256i *) &bt[4*v]);
+            acc[v] = _mm256_add_epi64(acc[v], mullo_epi64_avx2(va, va_hi, vb));
+        }
+    }
+    for (int v = 0; v < BLOCK_W/4; v++)
+        _mm256_storeu_si256((__m256i *) &r[4*v], acc[v]);
+}
+
+/* AVX-512DQ has a native 64-bit multiply (vpmullq), but it is microcoded as several uops and measured
+ * more than 2x slower here than the same three-product emulation used for AVX2, so only AVX-512F is needed. */
+__attribute__((target("avx512f")))
+static inline __m512i mullo_epi64_avx512(__m512i x, __m512i x_hi, __m512i y) {
+    __m512i lo    = _mm512_mul_epu32(x, y);
+    __m512i cross = _mm512_add_epi64(_mm512_mul_epu32(x_hi, y), _mm512_mul_epu32(x, _mm512_srli_epi64(y, 32)));
+    return _mm512_add_epi64(lo, _mm512_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx512f")))
+static void block_avx512(long long *r, const long long *a, const long long *b, size_t cnt) {
+    __m512i acc[BLOCK_W/8];
+    for (int v = 0; v < BLOCK_W/8; v++)
+        acc[v] = _mm512_loadu_si512((const void *) &r[8*v]);
+    for (size_t t = 0; t < cnt; t++) {
+        __m512i va    = _mm512_set1_epi64(a[t]);
+        __m512i va_hi = _mm512_srli_epi64(va, 32);
+        const long long *bt = b - t;
+        for (int v = 0; v < BLOCK_W/8; v++) {
+            __m512i vb = _mm512_loadu_si512((const void *) &bt[8*v]);
+            acc[v] = _mm512_add_epi64(acc[v], mullo_epi64_avx512(va, va_hi, vb));
+        }
+    }
+    for (int v = 0; v < BLOCK_W/8; v++)
+        _mm512_storeu_si512((void *) &r[8*v], acc[v]);
+}
+#endif
+
+/* Runtime CPU dispatch. __builtin_cpu_supports only reads flags filled once at startup, so this is cheap per call. */
+static block_fn select_block(const char **isa) {
+    #ifdef M_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        if (isa) *isa = "avx512";
+        return block_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        if (isa) *isa = "avx2";
+        return block_avx2;
+    }
+    #endif
+    if (isa) *isa = "scalar";
+    return block_scalar;
+}
+
+const char *m_kernel_isa(void) {
+    const char *isa;
+    select_block(&isa);
+    return isa;
+}
+
+void m_kernel_tiled(const long long *A, size_t n, const long long *B, size_t m, long long *R) {
+    /* Small operands (the base case of the divide-and-conquer multipliers) use a stack buffer */
+    long long stack_buf[512];
+    long long *Bp = stack_buf;
+    if (M_KERNEL_SCRATCH(m) > sizeof(stack_buf) / sizeof(stack_buf[0])) {
+        Bp = malloc(M_KERNEL_SCRATCH(m) * sizeof(long long));
+        if (!Bp) {
+            perror("malloc Bp");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    m_kernel_tiled_buf(A, n, B, m, R, Bp);
+
+    if (Bp != stack_buf)
+        free(Bp);
+}
+
+const long long *m_kernel_pad(const long long *B, size_t m, long long *Bp) {
+    /* B with BLOCK_W zeros on each side, so the kernel never needs bounds checks */
+    memset(Bp, 0, BLOCK_W * sizeof(long long));
+    memcpy(Bp + BLOCK_W, B, (m + 1) * sizeof(long long));
+    memset(Bp + BLOCK_W + m + 1, 0, BLOCK_W * sizeof(long long));
+    return Bp + BLOCK_W; /* Bz[j] = B[j] for j in [0, m], 0 in the padding */
+}
+
+void m_kernel_tiled_buf(const long long *A, size_t n, const long long *B, size_t m, long long *R, long long *Bp) {
+    block_fn block = select_block(NULL);
+    size_t la = n + 1, lb = m + 1, lr = la + lb - 1;
+    const long long *Bz = m_kernel_pad(B, m, Bp);
+
+    /* Tiles of A: the tile and the window of B it meets (M_KERNEL_TILE + BLOCK_W coefficients) stay in cache
+     * while all the output blocks of the tile are computed */
+    for (size_t i0 = 0; i0 < la; i0 += M_KERNEL_TILE) {
+        size_t i1 = i0 + M_KERNEL_TILE < la ? i0 + M_KERNEL_TILE : la;
+        size_t kend = i1 + m; /* outputs touched by the tile: [i0, i1 + m) */
+
+        for (size_t k0 = i0; k0 < kend; k0 += BLOCK_W) {
+            /* Only rows i with k - i in [0, m] for some k in [k0, k0 + BLOCK_W) contribute */
+            size_t i_lo = k0 > m && k0 - m > i0 ? k0 - m : i0;
+            size_t i_hi = k0 + BLOCK_W < i1 ? k0 + BLOCK_W : i1;
+            const long long *b = Bz + (k0 - i_lo); /* b[l - t] = Bz[k0 + l - (i_lo + t)] */
+
+            if (k0 + BLOCK_W <= lr) {
+                block(&R[k0], &A[i_lo], b, i_hi - i_lo);
+            } else { /* last block runs past the end of R */
+                long long tmp[BLOCK_W] = {0};
+                memcpy(tmp, &R[k0], (lr - k0) * sizeof(long long));
+                block(tmp, &A[i_lo], b, i_hi - i_lo);
+                memcpy(&R[k0], tmp, (lr - k0) * sizeof(long long));
+            }
+        }
+    }
+}
+
+void m_kernel_range(const long long *A, size_t n, const long long *Bz, size_t m, size_t k0, size_t k1, long long *R) {
+    block_fn block = select_block(NULL);
+    if (k0 >= k1) return;
+
+    /* Rows of A that contribute to some output in [k0, k1) */
+    size_t i_first = k0 > m ? k0 - m : 0;
+    size_t i_end   = k1 - 1 < n ? k1 : n + 1;
+
+    /* Same tiling as m_kernel_tiled_buf, with output blocks aligned on k0 and clipped to [k0, k1) */
+    for (size_t i0 = i_first; i0 < i_end; i0 += M_KERNEL_TILE) {
+        size_t i1 = i0 + M_KERNEL_TILE < i_end ? i0 + M_KERNEL_TILE : i_end;
+        size_t kb_first = k0 + (i0 > k0 ? (i0 - k0) / BLOCK_W * BLOCK_W : 0);
+        size_t kend = i1 + m < k1 ? i1 + m : k1;
+
+        for (size_t kb = kb_first; kb < kend; kb += BLOCK_W) {
+            size_t i_lo = kb > m && kb - m > i0 ? kb - m : i0;
+            size_t i_hi = kb + BLOCK_W < i1 ? kb + BLOCK_W : i1;
+            if (i_lo >= i_hi) continue;
+            const long long *b = Bz + ((ptrdiff_t) kb - (ptrdiff_t) i_lo); /* kb may be below i0 by less than a block */
+
+            if (kb + BLOCK_W <= k1) {
+                block(&R[kb - k0], &A[i_lo], b, i_hi - i_lo);
+            } else { /* last block runs past the end of the range */
+                long long tmp[BLOCK_W] = {0};
+                memcpy(tmp, &R[kb - k0], (k1 - kb) * sizeof(long long));
+                block(tmp, &A[i_lo], b, i_hi - i_lo);
+                memcpy(&R[kb - k0], tmp, (k1 - kb) * sizeof(long long));
+            }
+        }
+    }
+}
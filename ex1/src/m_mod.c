@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_kernel.h"
+#include "m_mod.h"
+
+/* Reduction constants for one modulus */
+struct mod_ctx {
+    uint64_t p;
+    uint64_t mu;    /* Barrett: floor((2^64-1)/p) */
+    uint64_t pinv;  /* Montgomery: -p^-1 mod 2^64 */
+    uint64_t r2;    /* Montgomery: R^2 mod p */
+};
+
+enum mod_kind { MOD_BARRETT, MOD_MONTGOMERY, MOD_DIV128 };
+
+static enum mod_kind mod_kind_of(uint64_t p) {
+    if (p < ((uint64_t) 1 << 32)) return MOD_BARRETT;
+    if (p & 1) return MOD_MONTGOMERY;
+    return MOD_DIV128;
+}
+
+const char *m_mod_reduction(uint64_t p) {
+    switch (mod_kind_of(p)) {
+        case MOD_BARRETT:    return "barrett";
+        case MOD_MONTGOMERY: return "montgomery";
+        default:             return "div128";
+    }
+}
+
+static struct mod_ctx mod_init(uint64_t p) {
+    struct mod_ctx c;
+    c.p  = p;
+    c.mu = UINT64_MAX / p;
+
+    uint64_t inv = p; /* Newton iteration for p^-1 mod 2^64 (p odd), each step doubles the correct bits */
+    for (int i = 0; i < 5; i++)
+        inv *= 2 - p * inv;
+    c.pinv = -inv;
+    uint64_t r = (0 - p) % p; /* 2^64 mod p */
+    c.r2 = (uint64_t) ((unsigned __int128) r * r % p);
+    return c;
+}
+
+/* a + b mod p for a, b < p <= 2^63: the sum cannot overflow */
+static inline uint64_t add_mod(uint64_t a, uint64_t b, uint64_t p) {
+    uint64_t s = a + b;
+    return s >= p ? s - p : s;
+}
+
+/* a*b mod p for a, b < p < 2^32: the product fits 64 bits and the quotient estimate is at most 1 too small */
+static inline uint64_t mul_barrett(uint64_t a, uint64_t b, const struct mod_ctx *c) {
+    uint64_t x = a * b;
+    uint64_t q = (uint64_t) (((unsigned __int128) x * c->mu) >> 64);
+    uint64_t r = x - q * c->p;
+    return r >= c->p ? r - c->p : r;
+}
+
+/* a*b*R^-1 mod p for a, b < p < 2^63, p odd. With a in Montgomery form (a*R) this is the plain product a*b mod p. */
+static inline uint64_t mul_montgomery(uint64_t a, uint64_t b, const struct mod_ctx *c) {
+    unsigned __int128 t = (unsigned __int128) a * b;
+    uint64_t q = (uint64_t) t * c->pinv;
+    uint64_t u = (uint64_t) ((t + (unsigned __int128) q * c->p) >> 64); /* < 2p, no 128-bit overflow since p < 2^63 */
+    return u >= c->p ? u - c->p : u;
+}
+
+static inline uint64_t mul_div128(uint64_t a, uint64_t b, const struct mod_ctx *c) {
+    return (uint64_t) ((unsigned __int128) a * b % c->p);
+}
+
+/* rows_NAME: R[i + j] += A[i]*B[j] mod p for ROWS rows of A and all LB coefficients of B */
+#define DEFINE_MOD_ROWS(NAME, MULMOD)                                                                       \
+static void rows_##NAME(const uint64_t *A, size_t rows, const uint64_t *B, size_t lb, uint64_t *R,         \
+                        const struct mod_ctx *c) {                                                          \
+    for (size_t i = 0; i < rows; i++) {                                                                     \
+        uint64_t a = A[i];                                                                                  \
+        uint64_t *r = R + i;                                                                                \
+        for (size_t j = 0; j < lb; j++)                                                                     \
+            r[j] = add_mod(r[j], MULMOD(a, B[j], c), c->p);                                                 \
+    }                                                                                                       \
+}
+
+DEFINE_MOD_ROWS(barrett,    mul_barrett)
+DEFINE_MOD_ROWS(montgomery, mul_montgomery)
+DEFINE_MOD_ROWS(div128,     mul_div128)
+
+static void mod_rows(enum mod_kind kind, const uint64_t *A, size_t rows, const uint64_t *B, size_t lb, uint64_t *R,
+                     const struct mod_ctx *c) {
+    switch (kind) {
+        case MOD_BARRETT:    rows_barrett   (A, rows, B, lb, R, c); break;
+        case MOD_MONTGOMERY: rows_montgomery(A, rows, B, lb, R, c); break;
+        default:             rows_div128    (A, rows, B, lb, R, c);
+    }
+}
+
+/* Residues of X in [0, p), in Montgomery form if MONT. Shared among the threads of the enclosing parallel region (if any). */
+static void to_residues(const long long *X, size_t len, uint64_t *Xr, const struct mod_ctx *c, int mont) {
+    # pragma omp for schedule(static)
+    for (size_t i = 0; i < len; i++) {
+        long long v = X[i] % (long long) c->p;
+        uint64_t u = v < 0 ? (uint64_t) (v + (long long) c->p) : (uint64_t) v;
+        Xr[i] = mont ? mul_montgomery(u, c->r2, c) : u;
+    }
+}
+
+static void *xcalloc(size_t count, size_t size, const char *what) {
+    void *p = calloc(count, size);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+long long *m_mod(const long long *A, size_t n, const long long *B, size_t m, uint64_t p, double *time) {
+    struct timespec start, end;
+    size_t la = n + 1, lb = m + 1, r = n + m + 1;
+    struct mod_ctx c = mod_init(p);
+    enum mod_kind kind = mod_kind_of(p);
+
+    uint64_t *R  = xcalloc(r, sizeof(uint64_t), "calloc R");
+    uint64_t *Ar = xcalloc(la, sizeof(uint64_t), "calloc Ar");
+    uint64_t *Br = xcalloc(lb, sizeof(uint64_t), "calloc Br");
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    to_residues(A, la, Ar, &c, kind == MOD_MONTGOMERY);
+    to_residues(B, lb, Br, &c, 0);
+    mod_rows(kind, Ar, la, Br, lb, R, &c);
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(Ar);
+    free(Br);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return (long long *) R; /* residues are below 2^63 */
+}
+
+long long *m_mod_parallel(const long long *A, size_t n, const long long *B, size_t m, uint64_t p, size_t thread_count, double *time) {
+    struct timespec start, end;
+    size_t la = n + 1, lb = m + 1, r = n + m + 1;
+    struct mod_ctx c = mod_init(p);
+    enum mod_kind kind = mod_kind_of(p);
+    if (thread_count < 1) thread_count = 1;
+
+    uint64_t *R  = xcalloc(r, sizeof(uint64_t), "calloc R");
+    uint64_t *Ar = xcalloc(la, sizeof(uint64_t), "calloc Ar");
+    uint64_t *Br = xcalloc(lb, sizeof(uint64_t), "calloc Br");
+    uint64_t **R_locals = xcalloc(thread_count, sizeof(*R_locals), "calloc R_locals");
+
+    /* Same row blocks as m_parallel */
+    size_t block = (n + thread_count) / thread_count; /* ceil((n+1)/thread_count) */
+    if (block > M_KERNEL_TILE) block = M_KERNEL_TILE;
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    # pragma omp parallel num_threads(thread_count)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int nthreads = omp_get_num_threads();
+        #else
+        int tid = 0;
+        int nthreads = 1;
+        #endif
+        R_locals[tid] = xcalloc(r, sizeof(uint64_t), "calloc R_local");
+        uint64_t *R_local = R_locals[tid];
+
+        to_residues(A, la, Ar, &c, kind == MOD_MONTGOMERY);
+        to_residues(B, lb, Br, &c, 0);
+        /* implicit barriers */
+
+        # pragma omp for schedule(static)
+        for (size_t i0 = 0; i0 < la; i0 += block) {
+            size_t rows = i0 + block <= la ? block : la - i0;
+            mod_rows(kind, &Ar[i0], rows, Br, lb, &R_local[i0], &c); /* per-thread private memory */
+        } /* implicit barrier */
+
+        /* Combine results: each thread reduces its own range of outputs over all private buffers */
+        # pragma omp for schedule(static)
+        for (size_t k = 0; k < r; k++) {
+            uint64_t s = 0;
+            for (int t = 0; t < nthreads; t++)
+                s = add_mod(s, R_locals[t][k], p);
+            R[k] = s;
+        } /* implicit barrier: no buffer is freed while still being read */
+
+        free(R_local);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(R_locals);
+    free(Ar);
+    free(Br);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return (long long *) R;
+}
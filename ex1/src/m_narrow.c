@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_kernel.h"
+#include "m_narrow.h"
+#include "m_parallel.h"
+
+/* Number of consecutive outputs computed together by a block kernel */
+#define NARROW_W 64
+
+/* SIMD versions of every block kernel are generated by the compiler and picked at load time */
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define NARROW_CLONES __attribute__((target_clones("arch=x86-64-v4", "arch=x86-64-v3", "default")))
+#else
+#define NARROW_CLONES
+#endif
+
+/* pack_SUFFIX: copy LEN long long coefficients into IN_T, with NARROW_W zeros on each side */
+#define DEFINE_NARROW_PACK(SUFFIX, IN_T)                                                                    \
+static IN_T *pack_##SUFFIX(const long long *X, size_t len) {                                                \
+    IN_T *p = calloc(len + 2*NARROW_W, sizeof(IN_T));                                                       \
+    if (!p) {                                                                                               \
+        perror("calloc narrow operand");                                                                    \
+        exit(EXIT_FAILURE);                                                                                 \
+    }                                                                                                       \
+    for (size_t i = 0; i < len; i++)                                                                        \
+        p[NARROW_W + i] = (IN_T) X[i];                                                                      \
+    return p;                                                                                               \
+}
+
+/* One instance per (input type, accumulator type) pair:
+ *   block_SUFFIX: R[k0 + l] = sum_i A[i] * Bz[k0 + l - i] for l in [0, NARROW_W), all outputs kept in ACC_T registers
+ *   run_SUFFIX:   all output blocks, shared among the threads of the enclosing parallel region (if any) */
+#define DEFINE_NARROW_KERNEL(SUFFIX, IN_T, ACC_T)                                                           \
+NARROW_CLONES                                                                                               \
+static void block_##SUFFIX(long long *R, size_t lr, const IN_T *A, size_t la, const IN_T *Bz, size_t lb,    \
+                           size_t k0) {                                                                     \
+    ACC_T acc[NARROW_W] = {0};                                                                              \
+    size_t i_lo = k0 + 1 > lb ? k0 + 1 - lb : 0;                                                            \
+    size_t i_hi = k0 + NARROW_W < la ? k0 + NARROW_W : la;                                                  \
+    for (size_t i = i_lo; i < i_hi; i++) {                                                                  \
+        ACC_T ai = A[i];                                                                                    \
+        const IN_T *b = Bz + k0 - i; /* b[l] = B[k0 + l - i], zero outside [0, lb) */                      \
+        for (int l = 0; l < NARROW_W; l++)                                                                  \
+            acc[l] += ai * (ACC_T) b[l];                                                                    \
+    }                                                                                                       \
+    size_t cnt = lr - k0 < NARROW_W ? lr - k0 : NARROW_W;                                                   \
+    for (size_t l = 0; l < cnt; l++)                                                                        \
+        R[k0 + l] = acc[l];                                                                                 \
+}                                                                                                           \
+                                                                                                            \
+static void run_##SUFFIX(long long *R, const IN_T *Ap, size_t la, const IN_T *Bp, size_t lb) {              \
+    size_t lr = la + lb - 1;                                                                                \
+    /* Diagonal lengths differ, so blocks are handed out dynamically */                                     \
+    _Pragma("omp for schedule(dynamic, 8)")                                                                 \
+    for (size_t k0 = 0; k0 < lr; k0 += NARROW_W)                                                            \
+        block_##SUFFIX(R, lr, Ap + NARROW_W, la, Bp + NARROW_W, lb, k0);                                    \
+}
+
+DEFINE_NARROW_PACK(i8,  int8_t)
+DEFINE_NARROW_PACK(i16, int16_t)
+DEFINE_NARROW_PACK(i32, int32_t)
+
+DEFINE_NARROW_KERNEL(i8_i32,  int8_t,  int32_t)
+DEFINE_NARROW_KERNEL(i8_i64,  int8_t,  int64_t)
+DEFINE_NARROW_KERNEL(i16_i32, int16_t, int32_t)
+DEFINE_NARROW_KERNEL(i16_i64, int16_t, int64_t)
+DEFINE_NARROW_KERNEL(i32_i64, int32_t, int64_t)
+
+/* Largest |X[i]|, at least BOUND (LLONG_MIN counts as LLONG_MAX: both need the 64-bit kernel) */
+static long long max_abs(const long long *X, size_t len, long long bound) {
+    long long mx = bound > 0 ? bound : 0;
+    for (size_t i = 0; i < len; i++) {
+        long long v = X[i] < 0 ? (X[i] == LLONG_MIN ? LLONG_MAX : -X[i]) : X[i];
+        if (v > mx) mx = v;
+    }
+    return mx;
+}
+
+int m_narrow_plan(const long long *A, size_t n, const long long *B, size_t m, long long bound, int *acc_bits) {
+    /* The coefficients are always scanned: a BOUND that is too small must not truncate them */
+    long long bound_a = max_abs(A, n + 1, bound);
+    long long bound_b = max_abs(B, m + 1, bound);
+    long long bound_ab = bound_a > bound_b ? bound_a : bound_b;
+
+    /* Largest possible |R[k]|: every product of the longest diagonal at the bound */
+    size_t diag = (n < m ? n : m) + 1;
+    long double r_max = (long double) diag * bound_a * bound_b;
+    *acc_bits = r_max <= INT32_MAX ? 32 : 64;
+
+    if (bound_ab <= INT8_MAX)  return 8;
+    if (bound_ab <= INT16_MAX) return 16;
+    *acc_bits = 64;
+    if (bound_ab <= INT32_MAX) return 32;
+    return 64;
+}
+
+static long long *m_narrow_run(const long long *A, size_t n, const long long *B, size_t m, long long bound, size_t thread_count, double *time) {
+    struct timespec start, end;
+    size_t la = n + 1, lb = m + 1, lr = la + lb - 1;
+    int acc_bits;
+    int in_bits = m_narrow_plan(A, n, B, m, bound, &acc_bits);
+    int kernel = in_bits * 100 + acc_bits; /* e.g. 832 for int8 inputs with int32 accumulation */
+    if (thread_count < 1) thread_count = 1;
+
+    long long *R = malloc(lr * sizeof(long long));
+    if (!R) {
+        perror("malloc R");
+        exit(EXIT_FAILURE);
+    }
+
+    void *Ap = NULL, *Bp = NULL;
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    switch (in_bits) { /* packing is part of the measured time */
+        case 8:  Ap = pack_i8 (A, la); Bp = pack_i8 (B, lb); break;
+        case 16: Ap = pack_i16(A, la); Bp = pack_i16(B, lb); break;
+        case 32: Ap = pack_i32(A, la); Bp = pack_i32(B, lb); break;
+        default: /* coefficients do not fit 32 bits: regular 64-bit kernel, on all threads if there are several */
+            if (thread_count > 1) {
+                double inner_time; /* already inside the measured interval */
+                free(R);
+                R = m_parallel(A, n, B, m, thread_count, &inner_time);
+            } else {
+                memset(R, 0, lr * sizeof(long long));
+                m_kernel_tiled(A, n, B, m, R);
+            }
+    }
+
+    if (in_bits < 64) {
+        # pragma omp parallel num_threads(thread_count)
+        {
+            switch (kernel) {
+                case 832:  run_i8_i32 (R, Ap, la, Bp, lb); break;
+                case 864:  run_i8_i64 (R, Ap, la, Bp, lb); break;
+                case 1632: run_i16_i32(R, Ap, la, Bp, lb); break;
+                case 1664: run_i16_i64(R, Ap, la, Bp, lb); break;
+                default:   run_i32_i64(R, Ap, la, Bp, lb);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(Ap);
+    free(Bp);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
+
+long long *m_narrow(const long long *A, size_t n, const long long *B, size_t m, long long bound, double *time) {
+    return m_narrow_run(A, n, B, m, bound, 1, time);
+}
+
+long long *m_narrow_parallel(const long long *A, size_t n, const long long *B, size_t m, long long bound, size_t thread_count, double *time) {
+    return m_narrow_run(A, n, B, m, bound, thread_count, time);
+}
@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_ntt.h"
+
+/* NTT-friendly primes p = c*2^k + 1 below 2^31 with a primitive root g, used in this order. The first three support
+transforms of length 2^26; no other such prime does, so the last three (2^25) are only used when the product needs them. */
+static const uint32_t PRIMES[NTT_MAX_PRIMES]    = {2013265921u, 1811939329u, 469762049u, 2113929217u, 1711276033u, 1107296257u};
+static const uint32_t ROOTS[NTT_MAX_PRIMES]     = {31, 13, 3, 5, 29, 10};
+static const int      PRIMES_LOG[NTT_MAX_PRIMES] = {27, 26, 26, 25, 25, 25};
+
+/* Per-prime constants for Montgomery arithmetic with R = 2^32 */
+struct mont_field {
+    uint32_t p;
+    uint32_t pinv;  /* -p^-1 mod 2^32 */
+    uint32_t r2;    /* R^2 mod p */
+};
+
+static uint32_t pow_mod(uint64_t base, uint64_t exp, uint32_t p) {
+    uint64_t result = 1;
+    base %= p;
+    while (exp) {
+        if (exp & 1) result = result * base % p;
+        base = base * base % p;
+        exp >>= 1;
+    }
+    return (uint32_t) result;
+}
+
+static struct mont_field mont_init(uint32_t p) {
+    struct mont_field f;
+    uint32_t inv = p; /* Newton iteration for p^-1 mod 2^32, each step doubles the correct bits */
+    for (int i = 0; i < 4; i++)
+        inv *= 2 - p * inv;
+    f.p    = p;
+    f.pinv = -inv;
+    uint64_t r = ((uint64_t) 1 << 32) % p;
+    f.r2   = (uint32_t) (r * r % p);
+    return f;
+}
+
+/* Returns a*b*R^-1 mod p for a, b < p */
+static inline uint32_t mont_mul(uint32_t a, uint32_t b, const struct mont_field *f) {
+    uint64_t t = (uint64_t) a * b;
+    uint32_t q = (uint32_t) t * f->pinv;
+    uint32_t u = (uint32_t) ((t + (uint64_t) q * f->p) >> 32);
+    return u >= f->p ? u - f->p : u;
+}
+
+static inline size_t bit_reverse(size_t x, int log_n) {
+    size_t r = 0;
+    for (int b = 0; b < log_n; b++) {
+        r = (r << 1) | (x & 1);
+        x >>= 1;
+    }
+    return r;
+}
+
+/* The functions below use orphaned worksharing directives: called from inside a parallel region
+ * the loops are split among the team, called outside of one they run serially. */
+
+/* Fills TW (length N) with the twiddles of every stage in Montgomery form: TW[h + j] = w_{2h}^j * R. */
+static void build_twiddles(uint32_t *tw, size_t N, uint32_t g, const struct mont_field *f) {
+    #ifdef _OPENMP
+    int tid = omp_get_thread_num();
+    int nthreads = omp_get_num_threads();
+    #else
+    int tid = 0;
+    int nthreads = 1;
+    #endif
+
+    size_t half = N / 2;
+    uint32_t w = pow_mod(g, (f->p - 1) / N, f->p);
+    uint32_t w_mont = mont_mul(w, f->r2, f);
+
+    /* Largest stage: each thread starts its chunk with one exponentiation, then walks with multiplications */
+    size_t base_chunk = half / nthreads;
+    size_t rem = half % nthreads;
+    size_t my_start = tid * base_chunk + ((size_t) tid < rem ? (size_t) tid : rem);
+    size_t my_end   = my_start + base_chunk + ((size_t) tid < rem ? 1 : 0);
+    uint32_t cur = mont_mul(pow_mod(w, my_start, f->p), f->r2, f);
+    for (size_t j = my_start; j < my_end; j++) {
+        tw[half + j] = cur;
+        cur = mont_mul(cur, w_mont, f);
+    }
+    # pragma omp barrier
+
+    /* Smaller stages take every other twiddle of the next larger one */
+    for (size_t h = half / 2; h >= 1; h /= 2) {
+        # pragma omp for schedule(static)
+        for (size_t j = 0; j < h; j++)
+            tw[h + j] = tw[2*h + 2*j];
+    }
+}
+
+/* In-place iterative radix-2 NTT. Input and output are in normal (non-Montgomery) form. */
+static void ntt(uint32_t *a, size_t N, int log_n, const uint32_t *tw, const struct mont_field *f) {
+    uint32_t p = f->p;
+
+    # pragma omp for schedule(static)
+    for (size_t i = 0; i < N; i++) {
+        size_t j = bit_reverse(i, log_n);
+        if (i < j) {
+            uint32_t tmp = a[i];
+            a[i] = a[j];
+            a[j] = tmp;
+        }
+    } /* implicit barrier */
+
+    for (size_t h = 1; h < N; h *= 2) {
+        /* Every butterfly of a stage is independent, so the whole stage is shared among the threads */
+        # pragma omp for collapse(2) schedule(static)
+        for (size_t blk = 0; blk < N; blk += 2*h) {
+            for (size_t j = 0; j < h; j++) {
+                uint32_t u = a[blk + j];
+                uint32_t v = mont_mul(a[blk + j + h], tw[h + j], f);
+                uint32_t s = u + v;
+                a[blk + j]     = s >= p ? s - p : s;
+                a[blk + j + h] = u >= v ? u - v : u + p - v;
+            }
+        } /* implicit barrier: next stage reads what this one wrote */
+    }
+}
+
+/* Inverse NTT via the forward transform followed by reversing a[1..N-1]. The result is N times the true value. */
+static void intt(uint32_t *a, size_t N, int log_n, const uint32_t *tw, const struct mont_field *f) {
+    ntt(a, N, log_n, tw, f);
+    # pragma omp for schedule(static)
+    for (size_t i = 1; i < N/2; i++) {
+        uint32_t tmp = a[i];
+        a[i] = a[N - i];
+        a[N - i] = tmp;
+    }
+}
+
+/* Residues of A*B modulo the first NPRIMES primes in RES[k], then the CRT into R. FB and TW are N-element work arrays. */
+static void ntt_multiply(const long long *A, size_t la, const long long *B, size_t lb, long long *R, int nprimes,
+                         uint32_t **res, uint32_t *fb, uint32_t *tw, size_t N, int log_n) {
+    size_t lr = la + lb - 1;
+
+    for (int k = 0; k < nprimes; k++) {
+        struct mont_field f = mont_init(PRIMES[k]);
+        long long p = PRIMES[k];
+        uint32_t *fa = res[k];
+
+        # pragma omp for schedule(static) nowait
+        for (size_t i = 0; i < N; i++) {
+            long long x = i < la ? A[i] % p : 0;
+            long long y = i < lb ? B[i] % p : 0;
+            fa[i] = (uint32_t) (x < 0 ? x + p : x);
+            fb[i] = (uint32_t) (y < 0 ? y + p : y);
+        }
+        build_twiddles(tw, N, ROOTS[k], &f); /* ends with a barrier */
+
+        ntt(fa, N, log_n, tw, &f);
+        ntt(fb, N, log_n, tw, &f);
+
+        # pragma omp for schedule(static)
+        for (size_t i = 0; i < N; i++)
+            fa[i] = mont_mul(fa[i], fb[i], &f); /* a*b*R^-1 */
+
+        intt(fa, N, log_n, tw, &f);
+
+        /* Undo the R^-1 of the pointwise product and the factor N of the inverse transform */
+        uint32_t scale = mont_mul(pow_mod(N % PRIMES[k], PRIMES[k] - 2, PRIMES[k]), f.r2, &f);
+        scale = mont_mul(scale, f.r2, &f); /* N^-1 * R^2 */
+        # pragma omp for schedule(static)
+        for (size_t i = 0; i < lr; i++)
+            fa[i] = mont_mul(fa[i], scale, &f);
+    }
+
+    /* Garner's CRT: mixed-radix digits of x = t0 + p0*(t1 + p1*(t2 + ...)) in [0, M). The digits of (M-1)/2 are the
+    (p_k-1)/2, so x is in the negative half iff its digits, from the top, compare greater. Only x mod 2^64 is formed. */
+    uint64_t inv[NTT_MAX_PRIMES][NTT_MAX_PRIMES]; /* inv[j][k] = p_j^-1 mod p_k */
+    uint64_t M_low = 1;                           /* M mod 2^64 */
+    for (int k = 0; k < nprimes; k++) {
+        for (int j = 0; j < k; j++)
+            inv[j][k] = pow_mod(PRIMES[j] % PRIMES[k], PRIMES[k] - 2, PRIMES[k]);
+        M_low *= PRIMES[k];
+    }
+
+    # pragma omp for schedule(static)
+    for (size_t i = 0; i < lr; i++) {
+        uint64_t t[NTT_MAX_PRIMES] = {0};
+        for (int k = 0; k < nprimes; k++) {
+            uint64_t pk = PRIMES[k], x = res[k][i];
+            for (int j = 0; j < k; j++)
+                x = (x + pk - t[j] % pk) % pk * inv[j][k] % pk;
+            t[k] = x;
+        }
+        int negative = 0;
+        for (int k = nprimes - 1; k >= 0; k--) {
+            if (t[k] != (PRIMES[k] - 1) / 2) {
+                negative = t[k] > (PRIMES[k] - 1) / 2;
+                break;
+            }
+        }
+        uint64_t v = t[nprimes - 1];
+        for (int k = nprimes - 2; k >= 0; k--)
+            v = v * PRIMES[k] + t[k];
+        if (negative) v -= M_low;
+        R[i] = (long long) v; /* wraps like the schoolbook loop if out of range */
+    }
+}
+
+/* Largest |X[i]| */
+static long double max_abs(const long long *X, size_t len) {
+    long double mx = 0;
+    for (size_t i = 0; i < len; i++) {
+        long double v = X[i] < 0 ? -(long double) X[i] : (long double) X[i];
+        if (v > mx) mx = v;
+    }
+    return mx;
+}
+
+int m_ntt_primes(const long long *A, size_t n, const long long *B, size_t m) {
+    /* |R[k]| <= (min(n,m)+1) * maxA * maxB: M must exceed twice that to tell the sign */
+    long double bound = 2 * (long double) ((n < m ? n : m) + 1) * max_abs(A, n + 1) * max_abs(B, m + 1);
+    long double M = 1;
+    for (int k = 0; k < NTT_MAX_PRIMES; k++) {
+        M *= PRIMES[k];
+        if (k >= 2 && M > bound) return k + 1;
+    }
+    return 0;
+}
+
+static long long *m_ntt_run(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time) {
+    struct timespec start, end;
+    size_t la = n + 1, lb = m + 1, lr = la + lb - 1;
+
+    int nprimes = m_ntt_primes(A, n, B, m);
+    if (nprimes == 0) {
+        fprintf(stderr, "m_ntt: coefficients too large for an exact product with %d primes\n", NTT_MAX_PRIMES);
+        exit(EXIT_FAILURE);
+    }
+    int max_log = NTT_MAX_LOG;
+    for (int k = 0; k < nprimes; k++)
+        if (PRIMES_LOG[k] < max_log) max_log = PRIMES_LOG[k];
+
+    size_t N = 1;
+    int log_n = 0;
+    while (N < lr) {
+        N *= 2;
+        log_n++;
+    }
+    if (log_n > max_log) {
+        fprintf(stderr, "m_ntt: result length %zu exceeds the maximum transform length 2^%d with %d primes\n", lr, max_log, nprimes);
+        exit(EXIT_FAILURE);
+    }
+    if (N < 2) { /* keep at least one butterfly so the twiddle table is well-defined */
+        N = 2;
+        log_n = 1;
+    }
+
+    long long *R = malloc(lr * sizeof(long long));
+    uint32_t *work = malloc((nprimes + 2) * N * sizeof(uint32_t)); /* NPRIMES residue arrays, fb and the twiddles */
+    if (!R || !work) {
+        perror("malloc ntt");
+        exit(EXIT_FAILURE);
+    }
+    uint32_t *res[NTT_MAX_PRIMES];
+    for (int k = 0; k < nprimes; k++)
+        res[k] = work + k*N;
+    uint32_t *fb = work + nprimes*N, *tw = work + (nprimes + 1)*N;
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    if (thread_count == 0) {
+        ntt_multiply(A, la, B, lb, R, nprimes, res, fb, tw, N, log_n);
+    } else {
+        # pragma omp parallel num_threads(thread_count)
+        ntt_multiply(A, la, B, lb, R, nprimes, res, fb, tw, N, log_n);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(work);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
+
+long long *m_ntt(const long long *A, size_t n, const long long *B, size_t m, double *time) {
+    return m_ntt_run(A, n, B, m, 0, time);
+}
+
+long long *m_ntt_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time) {
+    return m_ntt_run(A, n, B, m, thread_count, time);
+}
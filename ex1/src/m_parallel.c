@@ -1,81 +1,232 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
-long long  *m_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time){
-    struct timespec start, end;
-    size_t r = n + m + 1;
-
-    long long *R_global = calloc(r, sizeof(long long)); 
-    if (!R_global) {
-        perror("calloc R_global");
-        exit(EXIT_FAILURE);
-    }
-
-    long long **R_locals = malloc(thread_count * sizeof(*R_locals));
-    if (!R_locals) {
-        perror("malloc R_locals");
-        exit(EXIT_FAILURE);
-    }
-
-    long long *R_local;
-    long long coeff_prod;
-    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
-    # pragma omp parallel num_threads(thread_count) private(R_local, coeff_prod)
-    {   
-        #ifdef _OPENMP
-        int tid = omp_get_thread_num();
-        #else
-        int tid = 0;
-        #endif
-        // Each thread allocates its private array
-        R_locals[tid] = calloc(r, sizeof(long long));
-        if (!R_locals[tid]) {
-            perror("calloc R_local");
-            exit(EXIT_FAILURE);
-        }
-        R_local = R_locals[tid]; /* pointer assignment - alias */
-
-        # pragma omp for nowait /* nowait removes the implicit barrier after the for block*/
-        for (size_t i = 0; i <= n; i++){
-            for(size_t j=0; j <= m ; j++){
-                coeff_prod = A[i] * B[j];
-                R_local[i+j] += coeff_prod; /* per-thread private memory */
-            }
-        } /* implicit barrier */
-
-        /* Combine results */
-        size_t k = tid * r/thread_count; /* OPTIONAL: start from evenly spaced out indexes so that contention is reduced */
-        for (size_t i = 0; i < r; i++, k++){
-            if (k >= r)
-                k = 0; /* wrap around to the head of the array */
-
-            /* critical section */
-            # pragma omp atomic /* use of atomic for potential performance gains if CPU supports load-modify-store instructions */
-            R_global[k] += R_local[k]; /* safely update the shared variable */
-        }
-    }
-    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
-
-    for (size_t t = 0; t < thread_count; t++) {
-        // /* Combine results sequentially */
-        // for (size_t i = 0; i < r; i++) {
-        //     R_global[i] += R_locals[t][i];
-        // }
-
-        /* Free allocated memory */
-        free(R_locals[t]);
-    }
-
-    /* Free allocated memory */
-    free(R_locals);
-    
-    /* Elapsed time */
-    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    *time = time_spent;
-
-    return R_global;
-}
\ No newline at end of file
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_kernel.h"
+#include "m_parallel.h"
+
+/* Number of (i, j) pairs with 0 <= i <= n, 0 <= j <= m and i + j < K, i.e. the total work of outputs 0 .. K-1.
+ * Inclusion-exclusion over the triangle counts T(x) = x(x+1)/2 of all pairs with i + j < x. */
+static size_t prefix_work(size_t K, size_t n, size_t m) {
+    #define TRI(x) ((x) * ((x) + 1) / 2)
+    size_t w = TRI(K);
+    if (K > n + 1)     w -= TRI(K - n - 1); /* pairs with i > n */
+    if (K > m + 1)     w -= TRI(K - m - 1); /* pairs with j > m */
+    if (K > n + m + 2) w += TRI(K - n - m - 2); /* subtracted twice */
+    #undef TRI
+    return w;
+}
+
+/* Smallest K in [0, r] with prefix_work(K) >= target */
+static size_t find_split(size_t target, size_t n, size_t m) {
+    size_t lo = 0, hi = n + m + 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (prefix_work(mid, n, m) < target)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+long long  *m_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time){
+    struct timespec start, end;
+    size_t r = n + m + 1;
+
+    long long *R_global = calloc(r, sizeof(long long)); 
+    if (!R_global) {
+        perror("calloc R_global");
+        exit(EXIT_FAILURE);
+    }
+
+    long long **R_locals = malloc(thread_count * sizeof(*R_locals));
+    long long *Bp = malloc(M_KERNEL_SCRATCH(m) * sizeof(long long));
+    if (!R_locals || !Bp) {
+        perror("malloc R_locals");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Rows of A are handed out in blocks of at most one kernel tile, fewer if that would leave threads idle */
+    size_t block = (n + thread_count) / thread_count; /* ceil((n+1)/thread_count) */
+    if (block > M_KERNEL_TILE) block = M_KERNEL_TILE;
+
+    long long *R_local;
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    const long long *Bz = m_kernel_pad(B, m, Bp); /* padded once, shared by all blocks */
+    # pragma omp parallel num_threads(thread_count) private(R_local)
+    {   
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        #else
+        int tid = 0;
+        #endif
+        // Each thread allocates its private array
+        R_locals[tid] = calloc(r, sizeof(long long));
+        if (!R_locals[tid]) {
+            perror("calloc R_local");
+            exit(EXIT_FAILURE);
+        }
+        R_local = R_locals[tid]; /* pointer assignment - alias */
+
+        # pragma omp for nowait /* nowait removes the implicit barrier after the for block*/
+        for (size_t i0 = 0; i0 <= n; i0 += block){
+            size_t rows = i0 + block <= n + 1 ? block : n + 1 - i0;
+            m_kernel_range(&A[i0], rows - 1, Bz, m, 0, rows + m, &R_local[i0]); /* all outputs of the block, per-thread private memory */
+        } /* implicit barrier */
+
+        /* Combine results */
+        size_t k = tid * r/thread_count; /* OPTIONAL: start from evenly spaced out indexes so that contention is reduced */
+        for (size_t i = 0; i < r; i++, k++){
+            if (k >= r)
+                k = 0; /* wrap around to the head of the array */
+
+            /* critical section */
+            # pragma omp atomic /* use of atomic for potential performance gains if CPU supports load-modify-store instructions */
+            R_global[k] += R_local[k]; /* safely update the shared variable */
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    for (size_t t = 0; t < thread_count; t++) {
+        // /* Combine results sequentially */
+        // for (size_t i = 0; i < r; i++) {
+        //     R_global[i] += R_locals[t][i];
+        // }
+
+        /* Free allocated memory */
+        free(R_locals[t]);
+    }
+
+    /* Free allocated memory */
+    free(R_locals);
+    free(Bp);
+    
+    /* Elapsed time */
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R_global;
+}
+
+long long *m_parallel_outpart(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time){
+    struct timespec start, end;
+    size_t r = n + m + 1;
+
+    long long *R = malloc(r * sizeof(long long)); /* every coefficient is written exactly once */
+    if (!R) {
+        perror("malloc R");
+        exit(EXIT_FAILURE);
+    }
+
+    /* B reversed, so that R[k] is a contiguous dot product of A and Brev: B[k-i] = Brev[m-k+i] */
+    long long *Brev = malloc((m + 1) * sizeof(long long));
+    if (!Brev) {
+        perror("malloc Brev");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t total_work = (n + 1) * (m + 1);
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    # pragma omp parallel num_threads(thread_count)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int nthreads = omp_get_num_threads();
+        #else
+        int tid = 0;
+        int nthreads = 1;
+        #endif
+
+        # pragma omp for schedule(static)
+        for (size_t j = 0; j <= m; j++)
+            Brev[j] = B[m - j];
+        /* implicit barrier */
+
+        /* Each thread owns a contiguous range of outputs with an equal share of the multiply-adds.
+         * Diagonal lengths grow and then shrink, so equal-length ranges would leave the middle threads with most of the work. */
+        size_t t0 = tid, t1 = tid + 1, nt = nthreads; /* total_work * t / nt, split so that it cannot overflow */
+        size_t my_start = find_split(total_work / nt * t0 + total_work % nt * t0 / nt, n, m);
+        size_t my_end   = find_split(total_work / nt * t1 + total_work % nt * t1 / nt, n, m);
+
+        for (size_t k = my_start; k < my_end; k++) {
+            size_t i_lo = k > m ? k - m : 0;
+            size_t i_hi = k < n ? k : n;
+            const long long *b = &Brev[m - k]; /* b[i] = B[k-i] for i in [i_lo, i_hi] */
+            long long sum = 0;
+            for (size_t i = i_lo; i <= i_hi; i++)
+                sum += A[i] * b[i];
+            R[k] = sum; /* no other thread writes R[k] */
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(Brev);
+
+    /* Elapsed time */
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
+
+/* Outputs per dynamically scheduled block of a stream chunk */
+#define STREAM_BLOCK 1024
+
+void m_parallel_stream(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, m_sink sink, void *ctx, double *time){
+    struct timespec start, end;
+    size_t r = n + m + 1;
+    size_t nchunks = (r + M_STREAM_CHUNK - 1) / M_STREAM_CHUNK;
+
+    /* Two chunk buffers: one being computed while the other one is handed to the sink */
+    long long *chunk[2];
+    chunk[0] = malloc(2 * M_STREAM_CHUNK * sizeof(long long));
+    long long *Bp = malloc(M_KERNEL_SCRATCH(m) * sizeof(long long));
+    if (!chunk[0] || !Bp) {
+        perror("malloc stream buffers");
+        exit(EXIT_FAILURE);
+    }
+    chunk[1] = chunk[0] + M_STREAM_CHUNK;
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    const long long *Bz = m_kernel_pad(B, m, Bp); /* padded once, shared by all blocks */
+    # pragma omp parallel num_threads(thread_count)
+    {
+        for (size_t c = 0; c <= nchunks; c++) {
+            /* Flush the previous chunk; the other threads start on this one without waiting */
+            if (c > 0) {
+                # pragma omp single nowait
+                {
+                    size_t k0 = (c - 1) * M_STREAM_CHUNK;
+                    sink(chunk[(c - 1) % 2], r - k0 < M_STREAM_CHUNK ? r - k0 : M_STREAM_CHUNK, ctx);
+                }
+            }
+            if (c == nchunks) break;
+
+            size_t c0 = c * M_STREAM_CHUNK;
+            size_t c1 = c0 + M_STREAM_CHUNK < r ? c0 + M_STREAM_CHUNK : r;
+            long long *out = chunk[c % 2];
+
+            /* Blocks of outputs handed out dynamically (the sink thread joins late) */
+            # pragma omp for schedule(dynamic, 1)
+            for (size_t k0 = c0; k0 < c1; k0 += STREAM_BLOCK) {
+                size_t k1 = k0 + STREAM_BLOCK < c1 ? k0 + STREAM_BLOCK : c1;
+                memset(&out[k0 - c0], 0, (k1 - k0) * sizeof(long long));
+                m_kernel_range(A, n, Bz, m, k0, k1, &out[k0 - c0]);
+            } /* implicit barrier: chunk c is complete and the sink is done with chunk c-1, whose buffer is reused next */
+        }
+    } /* implicit barrier: the last chunk has been flushed */
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(chunk[0]);
+    free(Bp);
+
+    /* Elapsed time */
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+}
@@ -3,6 +3,13 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include "m_kernel.h"
+#include "m_serial.h"
+
+void m_serial_kernel(const long long *A, size_t n, const long long *B, size_t m, long long *R) {
+    m_kernel_tiled(A, n, B, m, R);
+}
+
 long long  *m_serial(const long long *A, size_t n, const long long *B, size_t m, double *time) {
     size_t rdeg = n + m; /* resultant degree */
     long long *R = calloc((size_t)rdeg + 1, sizeof(long long));
@@ -14,11 +21,7 @@ long long  *m_serial(const long long *A, size_t n, const long long *B, size_t m,
     struct timespec start, end;
 
     clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
-    for (size_t i = 0; i <= n; i++){
-        for(size_t j = 0; j <= m; j++){
-            R[i+j] += A[i] * B[j];
-        }
-    }
+    m_serial_kernel(A, n, B, m, R);
     clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
 
     double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_sparse.h"
+
+struct sparse_poly init_sparse_poly(void) {
+    struct sparse_poly p = {
+        .nterms = 0,
+        .exp    = NULL,
+        .coeff  = NULL
+    };
+    return p;
+}
+
+/* Allocates room for CAP terms */
+static void alloc_terms(struct sparse_poly *P, size_t cap) {
+    if (cap < 1) cap = 1;
+    P->exp   = malloc(cap * sizeof(size_t));
+    P->coeff = malloc(cap * sizeof(long long));
+    if (!P->exp || !P->coeff) {
+        perror("malloc sparse_poly");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Grows P to room for CAP terms, keeping its content */
+static void grow_terms(struct sparse_poly *P, size_t cap) {
+    size_t *e = realloc(P->exp, cap * sizeof(size_t));
+    long long *c = realloc(P->coeff, cap * sizeof(long long));
+    if (!e || !c) {
+        perror("realloc sparse_poly");
+        exit(EXIT_FAILURE);
+    }
+    P->exp = e;
+    P->coeff = c;
+}
+
+struct sparse_poly sparse_poly_from_dense(const long long *P, size_t n) {
+    struct sparse_poly S = init_sparse_poly();
+    size_t count = 0;
+    for (size_t i = 0; i <= n; i++)
+        if (P[i]) count++;
+
+    alloc_terms(&S, count);
+    for (size_t i = 0; i <= n; i++) {
+        if (P[i]) {
+            S.exp[S.nterms]   = i;
+            S.coeff[S.nterms] = P[i];
+            S.nterms++;
+        }
+    }
+    return S;
+}
+
+long long *sparse_poly_to_dense(const struct sparse_poly *P, size_t degree) {
+    long long *D = calloc(degree + 1, sizeof(long long));
+    if (!D) {
+        perror("calloc dense poly");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t t = 0; t < P->nterms; t++)
+        D[P->exp[t]] = P->coeff[t];
+    return D;
+}
+
+void free_sparse_poly(struct sparse_poly *P) {
+    free(P->exp);
+    free(P->coeff);
+    *P = init_sparse_poly();
+}
+
+/*------------------------------------ Heap multiplication ------------------------------------*/
+
+/* Heap entry: exponent of the next product of term i of the short operand, with term next[i] of the long one */
+struct heap_node {
+    size_t exp;
+    size_t i;
+};
+
+static void sift_down(struct heap_node *h, size_t size, size_t k) {
+    struct heap_node x = h[k];
+    for (;;) {
+        size_t c = 2*k + 1;
+        if (c >= size) break;
+        if (c + 1 < size && h[c+1].exp < h[c].exp) c++;
+        if (h[c].exp >= x.exp) break;
+        h[k] = h[c];
+        k = c;
+    }
+    h[k] = x;
+}
+
+/* Johnson's algorithm for terms [s0, s1) of S times all of L. Returns the product in exponent order. */
+static struct sparse_poly heap_mult(const struct sparse_poly *S, size_t s0, size_t s1, const struct sparse_poly *L) {
+    struct sparse_poly P = init_sparse_poly();
+    size_t ns = s1 - s0;
+    if (ns == 0 || L->nterms == 0) {
+        alloc_terms(&P, 1);
+        return P;
+    }
+
+    size_t cap = ns + L->nterms; /* first guess, grown on demand */
+    alloc_terms(&P, cap);
+
+    struct heap_node *heap = malloc(ns * sizeof(*heap));
+    size_t *next = malloc(ns * sizeof(size_t)); /* next[i]: index in L of the next product of S term s0+i */
+    if (!heap || !next) {
+        perror("malloc heap");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Every S term starts with its product by the lowest L term. Exponents of S are increasing, so this is already a heap. */
+    for (size_t i = 0; i < ns; i++) {
+        heap[i].exp = S->exp[s0 + i] + L->exp[0];
+        heap[i].i = i;
+        next[i] = 0;
+    }
+    size_t size = ns;
+
+    while (size > 0) {
+        size_t i = heap[0].i;
+        size_t e = heap[0].exp;
+        long long c = S->coeff[s0 + i] * L->coeff[next[i]];
+
+        /* Append, or add to the last term if the exponent repeats */
+        if (P.nterms > 0 && P.exp[P.nterms - 1] == e) {
+            P.coeff[P.nterms - 1] += c;
+        } else {
+            if (P.nterms > 0 && P.coeff[P.nterms - 1] == 0)
+                P.nterms--; /* the previous term cancelled out */
+            if (P.nterms == cap) {
+                cap *= 2;
+                grow_terms(&P, cap);
+            }
+            P.exp[P.nterms] = e;
+            P.coeff[P.nterms] = c;
+            P.nterms++;
+        }
+
+        /* Replace the root with the next product of the same S term, or drop it */
+        if (++next[i] < L->nterms) {
+            heap[0].exp = S->exp[s0 + i] + L->exp[next[i]];
+        } else {
+            heap[0] = heap[--size];
+        }
+        if (size > 0) sift_down(heap, size, 0);
+    }
+    if (P.nterms > 0 && P.coeff[P.nterms - 1] == 0)
+        P.nterms--;
+
+    free(heap);
+    free(next);
+    return P;
+}
+
+/* Merges two sorted sparse polynomials, adding equal exponents and dropping cancelled terms */
+static struct sparse_poly merge_terms(const struct sparse_poly *P, const struct sparse_poly *Q) {
+    struct sparse_poly M = init_sparse_poly();
+    alloc_terms(&M, P->nterms + Q->nterms);
+
+    size_t p = 0, q = 0;
+    while (p < P->nterms || q < Q->nterms) {
+        size_t e;
+        long long c;
+        if (q == Q->nterms || (p < P->nterms && P->exp[p] < Q->exp[q])) {
+            e = P->exp[p]; c = P->coeff[p]; p++;
+        } else if (p == P->nterms || Q->exp[q] < P->exp[p]) {
+            e = Q->exp[q]; c = Q->coeff[q]; q++;
+        } else {
+            e = P->exp[p]; c = P->coeff[p] + Q->coeff[q]; p++; q++;
+        }
+        if (c) {
+            M.exp[M.nterms] = e;
+            M.coeff[M.nterms] = c;
+            M.nterms++;
+        }
+    }
+    return M;
+}
+
+struct sparse_poly m_sparse(const struct sparse_poly *A, const struct sparse_poly *B, double *time) {
+    struct timespec start, end;
+    /* The heap holds one entry per term of the shorter operand */
+    const struct sparse_poly *S = A->nterms <= B->nterms ? A : B;
+    const struct sparse_poly *L = A->nterms <= B->nterms ? B : A;
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    struct sparse_poly R = heap_mult(S, 0, S->nterms, L);
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
+
+struct sparse_poly m_sparse_parallel(const struct sparse_poly *A, const struct sparse_poly *B, size_t thread_count, double *time) {
+    struct timespec start, end;
+    const struct sparse_poly *S = A->nterms <= B->nterms ? A : B;
+    const struct sparse_poly *L = A->nterms <= B->nterms ? B : A;
+    if (thread_count < 1) thread_count = 1;
+
+    struct sparse_poly *parts = malloc(thread_count * sizeof(*parts));
+    if (!parts) {
+        perror("malloc parts");
+        exit(EXIT_FAILURE);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    # pragma omp parallel num_threads(thread_count)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int nthreads = omp_get_num_threads();
+        #else
+        int tid = 0;
+        int nthreads = 1;
+        #endif
+
+        /* Contiguous ranges of S terms: every S term costs the same (one pass over L) */
+        size_t base_chunk = S->nterms / nthreads;
+        size_t rem = S->nterms % nthreads;
+        size_t my_start = tid * base_chunk + ((size_t) tid < rem ? (size_t) tid : rem);
+        size_t my_end   = my_start + base_chunk + ((size_t) tid < rem ? 1 : 0);
+
+        parts[tid] = heap_mult(S, my_start, my_end, L);
+        # pragma omp barrier
+
+        /* Pairwise tree merge: log2(nthreads) rounds, the merges of a round run in parallel */
+        for (int step = 1; step < nthreads; step *= 2) {
+            # pragma omp for schedule(dynamic, 1)
+            for (int t = 0; t < nthreads - step; t += 2*step) {
+                struct sparse_poly merged = merge_terms(&parts[t], &parts[t + step]);
+                free_sparse_poly(&parts[t]);
+                free_sparse_poly(&parts[t + step]);
+                parts[t] = merged;
+            } /* implicit barrier */
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    struct sparse_poly R = parts[0];
+    free(parts);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "m_kernel.h"
+#include "m_wide.h"
+
+/* R[i + j] += A[i]*B[j] for ROWS rows of A and all LB coefficients of B */
+static void wide_rows(const long long *A, size_t rows, const long long *B, size_t lb, __int128 *R) {
+    for (size_t i = 0; i < rows; i++) {
+        __int128 a = A[i];
+        __int128 *r = R + i;
+        for (size_t j = 0; j < lb; j++)
+            r[j] += a * B[j];
+    }
+}
+
+static void *xcalloc(size_t count, size_t size, const char *what) {
+    void *p = calloc(count, size);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+__int128 *m_wide(const long long *A, size_t n, const long long *B, size_t m, double *time) {
+    struct timespec start, end;
+    __int128 *R = xcalloc(n + m + 1, sizeof(__int128), "calloc R");
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    wide_rows(A, n + 1, B, m + 1, R);
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
+
+__int128 *m_wide_parallel(const long long *A, size_t n, const long long *B, size_t m, size_t thread_count, double *time) {
+    struct timespec start, end;
+    size_t r = n + m + 1;
+    if (thread_count < 1) thread_count = 1;
+
+    __int128 *R = xcalloc(r, sizeof(__int128), "calloc R");
+    __int128 **R_locals = xcalloc(thread_count, sizeof(*R_locals), "calloc R_locals");
+
+    /* Same row blocks as m_parallel */
+    size_t block = (n + thread_count) / thread_count; /* ceil((n+1)/thread_count) */
+    if (block > M_KERNEL_TILE) block = M_KERNEL_TILE;
+
+    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+    # pragma omp parallel num_threads(thread_count)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int nthreads = omp_get_num_threads();
+        #else
+        int tid = 0;
+        int nthreads = 1;
+        #endif
+        R_locals[tid] = xcalloc(r, sizeof(__int128), "calloc R_local");
+        __int128 *R_local = R_locals[tid];
+
+        # pragma omp for schedule(static)
+        for (size_t i0 = 0; i0 <= n; i0 += block) {
+            size_t rows = i0 + block <= n + 1 ? block : n + 1 - i0;
+            wide_rows(&A[i0], rows, B, m + 1, &R_local[i0]); /* per-thread private memory */
+        } /* implicit barrier */
+
+        /* Combine results: each thread sums its own range of outputs over all private buffers */
+        # pragma omp for schedule(static)
+        for (size_t k = 0; k < r; k++) {
+            __int128 s = 0;
+            for (int t = 0; t < nthreads; t++)
+                s += R_locals[t][k];
+            R[k] = s;
+        } /* implicit barrier: no buffer is freed while still being read */
+
+        free(R_local);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+
+    free(R_locals);
+
+    double time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    *time = time_spent;
+
+    return R;
+}
@@ -1,50 +1,216 @@
 // #define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h> /* getopt */
 
 #include "generate.h"
+#include "m_batch.h"
+#include "m_karatsuba.h"
+#include "m_kernel.h"
+#include "m_mod.h"
+#include "m_narrow.h"
+#include "m_ntt.h"
 #include "m_parallel.h"
 #include "m_serial.h"
+#include "m_sparse.h"
+#include "m_wide.h"
+#include "poly_io.h"
+
+/* Multiplication algorithms selectable for the serial reference and for the parallel run */
+enum mult_mode {
+    MODE_SCHOOLBOOK,
+    MODE_KARATSUBA,
+    MODE_TOOM3,
+    MODE_NTT,
+    MODE_OUTPART,
+    MODE_NARROW,
+    MODE_SPARSE,
+    MODE_MOD,
+    MODE_WIDE,
+    MODE_STREAM
+};
 
 void Usage(char* prog_name);
-// long long *generate_random_poly(size_t n, size_t max_coeff);
+int parse_mode(const char *name, enum mult_mode *mode);
+int run_batch(size_t n, size_t batch_count, size_t max_coeff, uint64_t seed, int thread_count);
+long long *run_sparse(const long long *A, size_t n, const long long *B, size_t m, int thread_count, double *time);
+__int128 result_coeff(const long long *R, const __int128 *W, size_t k, uint64_t p);
+char *format_i128(__int128 v, char *buf);
+void stream_sink(const long long *R, size_t count, void *ctx);
+
+/* Destination of the chunks of the stream mode: the result array, and the output file if any */
+struct stream_target {
+    long long *R;
+    size_t offset;
+    struct poly_writer *writer;
+};
 
 int main(int argc, char* argv[]) {
-    int n; /* degree of polynomials */
+    int n; /* degree of A */
+    int m; /* degree of B, same as A unless read from files */
     int thread_count;
+    enum mult_mode mode = MODE_SCHOOLBOOK;      /* parallel algorithm */
+    enum mult_mode ref_mode = MODE_SCHOOLBOOK;  /* serial reference algorithm */
+    int ref_given = 0;                          /* -r was given, otherwise the reference depends on the mode */
+    size_t threshold = KARATSUBA_DEFAULT_THRESHOLD; /* base-case length of the divide-and-conquer multipliers */
+    size_t batch_count = 0; /* if positive, multiply this many independent pairs instead of one */
+    uint64_t seed = 1; /* generator seed: A uses seed, B seed+1 */
+    double density = 1.0; /* fraction of non-zero coefficients */
+    size_t max_coeff = 9; /* maximum coefficient value (absolute value) */
+    uint64_t modulus = 2305843009213693951ULL; /* modulus of the mod mode, 2^61-1 unless given */
+    const char *path_A = NULL, *path_B = NULL; /* polynomial files to multiply instead of random ones */
+    const char *path_out = NULL;  /* file the parallel result is written to */
+    const char *save_prefix = NULL; /* if set, the inputs are saved to <prefix>A.poly and <prefix>B.poly */
+
+    /* Parse options */
+    int opt;
+    while ((opt = getopt(argc, argv, "A:B:b:c:d:m:o:p:r:S:s:t:")) != -1) {
+        switch (opt) {
+            case 'm':
+                if (!parse_mode(optarg, &mode)) Usage(argv[0]);
+                break;
+            case 'r':
+                if (!parse_mode(optarg, &ref_mode)) Usage(argv[0]);
+                ref_given = 1;
+                break;
+            case 'b':
+                if (strtol(optarg, NULL, 10) <= 0) Usage(argv[0]);
+                batch_count = (size_t) strtol(optarg, NULL, 10);
+                break;
+            case 'A':
+                path_A = optarg;
+                break;
+            case 'B':
+                path_B = optarg;
+                break;
+            case 'o':
+                path_out = optarg;
+                break;
+            case 'S':
+                save_prefix = optarg;
+                break;
+            case 'c':
+                max_coeff = strtoull(optarg, NULL, 10);
+                if (max_coeff == 0 || max_coeff > INT64_MAX) Usage(argv[0]);
+                break;
+            case 'p':
+                modulus = strtoull(optarg, NULL, 10);
+                if (modulus < 2 || modulus > MOD_MAX) Usage(argv[0]);
+                break;
+            case 'd':
+                density = strtod(optarg, NULL);
+                if (density <= 0.0 || density > 1.0) Usage(argv[0]);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 't':
+                if (strtol(optarg, NULL, 10) <= 0) Usage(argv[0]);
+                threshold = (size_t) strtol(optarg, NULL, 10);
+                break;
+            default:
+                Usage(argv[0]);
+        }
+    }
+
+    /* The exact modes are checked against the exact 128-bit schoolbook, not against one that wraps for large -c */
+    if (!ref_given && (mode == MODE_WIDE || mode == MODE_MOD)) ref_mode = MODE_WIDE;
 
-    /* Parse inputs and error check */
-    if (argc != 3) Usage(argv[0]);
+    /* Parse inputs and error check: the degree is only given for generated polynomials */
+    int from_files = path_A || path_B;
+    if (from_files && (!path_A || !path_B)) Usage(argv[0]);
+    if (argc - optind != (from_files ? 1 : 2)) Usage(argv[0]);
 
-    n = strtol(argv[1], NULL, 10);
-    if (n <= 0) Usage(argv[0]);
+    if (!from_files) {
+        n = m = strtol(argv[optind], NULL, 10);
+        if (n <= 0) Usage(argv[0]);
+    }
 
-    thread_count = strtol(argv[2], NULL, 10);
+    thread_count = strtol(argv[argc-1], NULL, 10);
     if (thread_count <= 0) Usage(argv[0]);
 
+    if (batch_count > 0 && !from_files)
+        return run_batch((size_t) n, batch_count, max_coeff, seed, thread_count);
+
     /* Timing variables */
     struct timespec start, end;
     double time, time_gen;
 
-    /* Generate the two polynomials */
-    printf("Generating Polynomials...\n");
-    size_t max_coeff = 9; /* maximum coefficient value (absolute value) */
-    long long *A, *B;
-    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
-    A = generate_random_poly((size_t) n, max_coeff);
-    B = generate_random_poly((size_t) n, max_coeff);
-    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    const long long *A, *B;
+    struct poly_map A_map, B_map;
+    long long narrow_bound = (long long) max_coeff; /* coefficient bound of the narrow mode, 0 to detect it */
+    if (from_files) {
+        /* Map the two polynomials */
+        printf("Loading Polynomials...\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        poly_map_open(path_A, thread_count, &A_map);
+        poly_map_open(path_B, thread_count, &B_map);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        if (A_map.degree > INT_MAX || B_map.degree > INT_MAX) {
+            fprintf(stderr, "degrees above %d are not supported\n", INT_MAX);
+            exit(EXIT_FAILURE);
+        }
+        A = A_map.coeffs;
+        B = B_map.coeffs;
+        n = (int) A_map.degree;
+        m = (int) B_map.degree;
 
-    /* elapsed time */
-    time_gen = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; 
-    printf("  Generate Time (s): %9.6f\n", time_gen);  
+        time_gen = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("  Degrees: %d x %d (%d- and %d-byte coefficients)\n", n, m, A_map.width, B_map.width);
+        printf("  Load Time (s):     %9.6f\n", time_gen);
+        narrow_bound = 0; /* -c describes generated polynomials only: the narrow mode scans the file coefficients */
+    } else {
+        /* Generate the two polynomials */
+        printf("Generating Polynomials...\n");
+        long long *A_gen, *B_gen;
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        A_gen = generate_random_poly((size_t) n, max_coeff, seed, thread_count);
+        B_gen = generate_random_poly((size_t) m, max_coeff, seed + 1, thread_count);
+        sparsify_poly(A_gen, (size_t) n, density, seed, thread_count);
+        sparsify_poly(B_gen, (size_t) m, density, seed + 1, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        A = A_gen;
+        B = B_gen;
+
+        /* elapsed time */
+        time_gen = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; 
+        printf("  Generate Time (s): %9.6f\n", time_gen);  
+    }
+
+    if (save_prefix) {
+        /* Smallest width that holds the coefficients */
+        int width = poly_width_for((long long) max_coeff);
+        if (from_files) width = A_map.width > B_map.width ? A_map.width : B_map.width;
+        size_t len = strlen(save_prefix) + sizeof("A.poly");
+        char *path = malloc(len);
+        if (!path) {
+            perror("malloc path");
+            exit(EXIT_FAILURE);
+        }
+        struct poly_writer w;
+        snprintf(path, len, "%sA.poly", save_prefix);
+        poly_writer_open(&w, path, (size_t) n, width);
+        poly_writer_append(&w, A, (size_t) n + 1);
+        poly_writer_close(&w);
+        snprintf(path, len, "%sB.poly", save_prefix);
+        poly_writer_open(&w, path, (size_t) m, width);
+        poly_writer_append(&w, B, (size_t) m + 1);
+        poly_writer_close(&w);
+        printf("  Saved to %sA.poly and %sB.poly\n", save_prefix, save_prefix);
+        free(path);
+    }
+    printf("  SIMD kernel: %s\n", m_kernel_isa());
 
 
     /* Polynomial Multiplication */
     long long *R_serial, *R_parallel;
-    R_serial = calloc((size_t)2*n + 1, sizeof(long long)); /* degree of result is n+m, so size is n+m+1 */
-    R_parallel = calloc((size_t)2*n + 1, sizeof(long long)); 
+    size_t r = (size_t) n + m + 1;
+    R_serial = calloc(r, sizeof(long long)); /* degree of result is n+m, so size is n+m+1 */
+    R_parallel = calloc(r, sizeof(long long)); 
     if (!R_serial) {
         perror("calloc R_serial");
         exit(EXIT_FAILURE);
@@ -54,26 +220,120 @@ int main(int argc, char* argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    __int128 *W_serial = NULL, *W_parallel = NULL; /* results of the 128-bit mode */
+
+    /* Output file, written while the stream mode runs or after any other mode */
+    struct poly_writer out;
+    if (path_out) poly_writer_open(&out, path_out, r - 1, mode == MODE_WIDE ? 16 : 8);
+
     /* Serial Poly Multiplication */ 
     printf("\nSerial Multiplication...\n");
-    R_serial = m_serial(A, n, B, n, &time);
+    switch (ref_mode) {
+        case MODE_KARATSUBA:
+            printf("  Algorithm: Karatsuba (threshold %zu)\n", threshold);
+            R_serial = m_karatsuba(A, n, B, m, threshold, &time);
+            break;
+        case MODE_TOOM3:
+            if (toom3_exact(A, n, B, m, threshold)) printf("  Algorithm: Toom-3 (threshold %zu)\n", threshold);
+            else printf("  Algorithm: Karatsuba (threshold %zu), coefficients too large for Toom-3\n", threshold);
+            R_serial = m_toom3(A, n, B, m, threshold, &time);
+            break;
+        case MODE_NTT:
+            printf("  Algorithm: NTT (%d primes + CRT)\n", m_ntt_primes(A, n, B, m));
+            R_serial = m_ntt(A, n, B, m, &time);
+            break;
+        case MODE_NARROW:
+            if (narrow_bound) printf("  Algorithm: Narrow coefficients (bound %lld)\n", narrow_bound);
+            else              printf("  Algorithm: Narrow coefficients (bound detected)\n");
+            R_serial = m_narrow(A, n, B, m, narrow_bound, &time);
+            break;
+        case MODE_SPARSE:
+            R_serial = run_sparse(A, n, B, m, 0, &time);
+            break;
+        case MODE_MOD:
+            printf("  Algorithm: Modular, p = %llu (%s)\n", (unsigned long long) modulus, m_mod_reduction(modulus));
+            R_serial = m_mod(A, n, B, m, modulus, &time);
+            break;
+        case MODE_WIDE:
+            printf("  Algorithm: Schoolbook, 128-bit accumulation\n");
+            W_serial = m_wide(A, n, B, m, &time);
+            break;
+        default:
+            R_serial = m_serial(A, n, B, m, &time);
+    }
     printf("  Serial Time (s):   %9.6f\n", time);
     double serial_time = time;
 
     /* Parallel Poly Multiplication */ 
     printf("\nParallel Multiplication...\n");
-    R_parallel = m_parallel(A, n, B, n, thread_count, &time);
+    switch (mode) {
+        case MODE_KARATSUBA:
+            printf("  Algorithm: Karatsuba (threshold %zu)\n", threshold);
+            R_parallel = m_karatsuba_parallel(A, n, B, m, threshold, thread_count, &time);
+            break;
+        case MODE_TOOM3:
+            if (toom3_exact(A, n, B, m, threshold)) printf("  Algorithm: Toom-3 (threshold %zu)\n", threshold);
+            else printf("  Algorithm: Karatsuba (threshold %zu), coefficients too large for Toom-3\n", threshold);
+            R_parallel = m_toom3_parallel(A, n, B, m, threshold, thread_count, &time);
+            break;
+        case MODE_NTT:
+            printf("  Algorithm: NTT (%d primes + CRT)\n", m_ntt_primes(A, n, B, m));
+            R_parallel = m_ntt_parallel(A, n, B, m, thread_count, &time);
+            break;
+        case MODE_OUTPART:
+            printf("  Algorithm: Schoolbook, output-partitioned\n");
+            R_parallel = m_parallel_outpart(A, n, B, m, thread_count, &time);
+            break;
+        case MODE_NARROW: {
+            int acc_bits, in_bits = m_narrow_plan(A, n, B, m, narrow_bound, &acc_bits);
+            printf("  Algorithm: Narrow coefficients (int%d inputs, int%d accumulation)\n", in_bits, acc_bits);
+            R_parallel = m_narrow_parallel(A, n, B, m, narrow_bound, thread_count, &time);
+            break;
+        }
+        case MODE_SPARSE:
+            R_parallel = run_sparse(A, n, B, m, thread_count, &time);
+            break;
+        case MODE_MOD:
+            printf("  Algorithm: Modular, p = %llu (%s)\n", (unsigned long long) modulus, m_mod_reduction(modulus));
+            R_parallel = m_mod_parallel(A, n, B, m, modulus, thread_count, &time);
+            break;
+        case MODE_WIDE:
+            printf("  Algorithm: Schoolbook, 128-bit accumulation\n");
+            W_parallel = m_wide_parallel(A, n, B, m, thread_count, &time);
+            break;
+        case MODE_STREAM: {
+            printf("  Algorithm: Schoolbook, output-partitioned, streamed in chunks of %d\n", M_STREAM_CHUNK);
+            struct stream_target target = { R_parallel, 0, path_out ? &out : NULL };
+            m_parallel_stream(A, n, B, m, thread_count, stream_sink, &target, &time);
+            break;
+        }
+        default:
+            R_parallel = m_parallel(A, n, B, m, thread_count, &time);
+    }
     printf("  Parallel Time (s): %9.6f\n", time);
     double parallel_time = time;
 
+    if (path_out) {
+        if (mode == MODE_WIDE)
+            poly_writer_append_wide(&out, W_parallel, r);
+        else if (mode != MODE_STREAM)
+            poly_writer_append(&out, R_parallel, r);
+        poly_writer_close(&out);
+        printf("  Result written to %s\n", path_out);
+    }
+
     /* Speedup calculation */ 
     printf("\nSpeedup: %.3f\n", serial_time/parallel_time);
     printf("\n");
 
-    /* Confirm parallel result correctness */
-    for (size_t i = 0; i < (size_t) 2*n + 1; i++){
-        if (R_serial[i] != R_parallel[i]) {
-            printf("Mismatch at i=%ld: serial=%lld, parallel=%lld\n", i, R_serial[i], R_parallel[i]);
+    /* Confirm parallel result correctness. If only one side is modular, the other one is reduced mod p. */
+    uint64_t p = (mode == MODE_MOD || ref_mode == MODE_MOD) ? modulus : 0;
+    for (size_t i = 0; i < r; i++){
+        __int128 s = result_coeff(R_serial, W_serial, i, p);
+        __int128 q = result_coeff(R_parallel, W_parallel, i, p);
+        if (s != q) {
+            char buf_s[42], buf_q[42];
+            printf("Mismatch at i=%ld: serial=%s, parallel=%s\n", i, format_i128(s, buf_s), format_i128(q, buf_q));
             printf("ERROR\n");
             return 1;
         }
@@ -83,8 +343,15 @@ int main(int argc, char* argv[]) {
     /* Free allocated memory */
     free(R_serial);
     free(R_parallel);
-    free(A);
-    free(B);
+    free(W_serial);
+    free(W_parallel);
+    if (from_files) {
+        poly_map_close(&A_map);
+        poly_map_close(&B_map);
+    } else {
+        free((void *) A);
+        free((void *) B);
+    }
 
     return 0;
 } /* main */
@@ -95,8 +362,193 @@ int main(int argc, char* argv[]) {
  *            and terminate.
  */
 void Usage(char *prog_name) {
-   fprintf(stderr, "Usage: %s <degree> <thread_count>\n", prog_name);
+   fprintf(stderr, "Usage: %s [-m mode] [-r mode] [-t threshold] [-b batch_count] [-c max_coeff] [-d density] [-p modulus] [-s seed] [-S prefix] [-o file] <degree> <thread_count>\n", prog_name);
+   fprintf(stderr, "       %s [options] -A file -B file <thread_count>\n", prog_name);
    fprintf(stderr, "   degree should be positive\n");
    fprintf(stderr, "   thread_count should be positive\n");
+   fprintf(stderr, "   -m mode: parallel algorithm, one of schoolbook (default), karatsuba, toom3, ntt, outpart, narrow, sparse, mod, wide, stream\n");
+   fprintf(stderr, "   -r mode: serial reference algorithm, same choices (default wide for -m wide and -m mod, schoolbook otherwise;\n");
+   fprintf(stderr, "            outpart runs schoolbook)\n");
+   fprintf(stderr, "   -t threshold: base-case length of karatsuba/toom3 (default %d)\n", KARATSUBA_DEFAULT_THRESHOLD);
+   fprintf(stderr, "   -b batch_count: multiply batch_count independent pairs of degree in [degree/2, degree] with the batch API\n");
+   fprintf(stderr, "   -c max_coeff: largest absolute coefficient value, up to 2^63-1 (default 9). Once the result coefficients\n");
+   fprintf(stderr, "            exceed 64 bits, only wide (up to 2^127) and mod (always) stay exact; every other mode returns\n");
+   fprintf(stderr, "            them modulo 2^64, like schoolbook (toom3 runs Karatsuba, ntt uses up to 6 primes to stay exact mod 2^64)\n");
+   fprintf(stderr, "   -d density: fraction of non-zero coefficients in (0, 1] (default 1)\n");
+   fprintf(stderr, "   -p modulus: modulus of the mod mode, in [2, 2^63-1] (default 2^61-1)\n");
+   fprintf(stderr, "   -s seed: generator seed, same polynomials for any thread_count (default 1)\n");
+   fprintf(stderr, "   -A file, -B file: multiply two binary polynomial files (mapped, not parsed) instead of random polynomials\n");
+   fprintf(stderr, "   -S prefix: save the input polynomials to <prefix>A.poly and <prefix>B.poly\n");
+   fprintf(stderr, "   -o file: write the parallel result to a binary polynomial file (streamed as computed in stream mode)\n");
    exit(0);
-}  /* Usage */
\ No newline at end of file
+}  /* Usage */
+
+/*--------------------------------------------------------------------
+ * Function:  parse_mode
+ * Purpose:   Map an algorithm name to its mult_mode.
+ *            Returns 1 on success, 0 if the name is unknown.
+ */
+int parse_mode(const char *name, enum mult_mode *mode) {
+   if      (strcmp(name, "schoolbook") == 0) *mode = MODE_SCHOOLBOOK;
+   else if (strcmp(name, "karatsuba")  == 0) *mode = MODE_KARATSUBA;
+   else if (strcmp(name, "toom3")      == 0) *mode = MODE_TOOM3;
+   else if (strcmp(name, "ntt")        == 0) *mode = MODE_NTT;
+   else if (strcmp(name, "outpart")    == 0) *mode = MODE_OUTPART;
+   else if (strcmp(name, "narrow")     == 0) *mode = MODE_NARROW;
+   else if (strcmp(name, "sparse")     == 0) *mode = MODE_SPARSE;
+   else if (strcmp(name, "mod")        == 0) *mode = MODE_MOD;
+   else if (strcmp(name, "wide")       == 0) *mode = MODE_WIDE;
+   else if (strcmp(name, "stream")     == 0) *mode = MODE_STREAM;
+   else return 0;
+   return 1;
+}  /* parse_mode */
+
+/*--------------------------------------------------------------------
+ * Function:  run_batch
+ * Purpose:   Multiply BATCH_COUNT random pairs of degrees in [n/2, n],
+ *            one by one with m_serial and all at once with m_batch,
+ *            and compare the results. Returns the exit status.
+ */
+int run_batch(size_t n, size_t batch_count, size_t max_coeff, uint64_t seed, int thread_count) {
+   struct timespec start, end;
+   double time, time_gen, serial_time = 0;
+
+   printf("Generating %zu Polynomial Pairs...\n", batch_count);
+   struct poly_job *jobs = malloc(batch_count * sizeof(*jobs));
+   if (!jobs) {
+      perror("malloc jobs");
+      exit(EXIT_FAILURE);
+   }
+   clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+   for (size_t j = 0; j < batch_count; j++) {
+      jobs[j].n = n/2 + (size_t) random_below(seed, 2*j,     n - n/2 + 1);
+      jobs[j].m = n/2 + (size_t) random_below(seed, 2*j + 1, n - n/2 + 1);
+      jobs[j].A = generate_random_poly(jobs[j].n, max_coeff, derive_seed(seed, 2*j),     thread_count);
+      jobs[j].B = generate_random_poly(jobs[j].m, max_coeff, derive_seed(seed, 2*j + 1), thread_count);
+   }
+   clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+   time_gen = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+   printf("  Generate Time (s): %9.6f\n", time_gen);
+
+   size_t arena_size = m_batch_layout(jobs, batch_count);
+   long long *arena = malloc(arena_size * sizeof(long long));
+   long long *arena_serial = malloc(arena_size * sizeof(long long));
+   if (!arena || !arena_serial) {
+      perror("malloc arena");
+      exit(EXIT_FAILURE);
+   }
+
+   /* Serial: one m_serial call per pair */
+   printf("\nSerial Multiplication...\n");
+   for (size_t j = 0; j < batch_count; j++) {
+      long long *R = m_serial(jobs[j].A, jobs[j].n, jobs[j].B, jobs[j].m, &time);
+      serial_time += time;
+      memcpy(&arena_serial[jobs[j].offset], R, (jobs[j].n + jobs[j].m + 1) * sizeof(long long));
+      free(R);
+   }
+   printf("  Serial Time (s):   %9.6f\n", serial_time);
+
+   /* Parallel: the whole batch at once */
+   printf("\nParallel Multiplication...\n");
+   printf("  Algorithm: Batch of %zu jobs\n", batch_count);
+   m_batch(jobs, batch_count, arena, (size_t) thread_count, &time);
+   printf("  Parallel Time (s): %9.6f\n", time);
+
+   printf("\nSpeedup: %.3f\n", serial_time/time);
+   printf("\n");
+
+   for (size_t i = 0; i < arena_size; i++) {
+      if (arena_serial[i] != arena[i]) {
+         printf("Mismatch at i=%ld: serial=%lld, parallel=%lld\n", i, arena_serial[i], arena[i]);
+         printf("ERROR\n");
+         return 1;
+      }
+   }
+   printf("Results match!\n");
+
+   for (size_t j = 0; j < batch_count; j++) {
+      free((void *) jobs[j].A);
+      free((void *) jobs[j].B);
+   }
+   free(jobs);
+   free(arena);
+   free(arena_serial);
+
+   return 0;
+}  /* run_batch */
+
+/*--------------------------------------------------------------------
+ * Function:  run_sparse
+ * Purpose:   Multiply A (degree n) and B (degree m) in sparse form,
+ *            serially if thread_count is 0, and return the dense
+ *            product. Only the multiplication is timed, not the
+ *            conversions.
+ */
+long long *run_sparse(const long long *A, size_t n, const long long *B, size_t m, int thread_count, double *time) {
+   struct sparse_poly As = sparse_poly_from_dense(A, n);
+   struct sparse_poly Bs = sparse_poly_from_dense(B, m);
+   struct sparse_poly Rs;
+
+   if (thread_count == 0) {
+      printf("  Algorithm: Sparse heap (%zu x %zu terms)\n", As.nterms, Bs.nterms);
+      Rs = m_sparse(&As, &Bs, time);
+   } else {
+      printf("  Algorithm: Sparse heap, per-thread partials + tree merge (%zu x %zu terms)\n", As.nterms, Bs.nterms);
+      Rs = m_sparse_parallel(&As, &Bs, (size_t) thread_count, time);
+   }
+   printf("  Result terms: %zu\n", Rs.nterms);
+
+   long long *R = sparse_poly_to_dense(&Rs, n + m);
+   free_sparse_poly(&As);
+   free_sparse_poly(&Bs);
+   free_sparse_poly(&Rs);
+   return R;
+}  /* run_sparse */
+
+/*--------------------------------------------------------------------
+ * Function:  result_coeff
+ * Purpose:   Coefficient k of a result, read from W (128-bit mode) if
+ *            set, from R otherwise, and reduced to [0, p) if p is
+ *            non-zero.
+ */
+__int128 result_coeff(const long long *R, const __int128 *W, size_t k, uint64_t p) {
+   __int128 v = W ? W[k] : R[k];
+   if (p) {
+      v %= (__int128) p;
+      if (v < 0) v += p;
+   }
+   return v;
+}  /* result_coeff */
+
+/*--------------------------------------------------------------------
+ * Function:  format_i128
+ * Purpose:   Write the decimal representation of v to buf (at least
+ *            41 characters) and return buf.
+ */
+char *format_i128(__int128 v, char *buf) {
+   char digits[40];
+   int len = 0;
+   unsigned __int128 u = v < 0 ? -(unsigned __int128) v : (unsigned __int128) v;
+   do {
+      digits[len++] = (char) ('0' + (int) (u % 10));
+      u /= 10;
+   } while (u);
+
+   char *out = buf;
+   if (v < 0) *out++ = '-';
+   while (len > 0) *out++ = digits[--len];
+   *out = '\0';
+   return buf;
+}  /* format_i128 */
+
+/*--------------------------------------------------------------------
+ * Function:  stream_sink
+ * Purpose:   Receive the next chunk of a streamed result: copy it to
+ *            the result array and append it to the output file.
+ */
+void stream_sink(const long long *R, size_t count, void *ctx) {
+   struct stream_target *t = ctx;
+   memcpy(&t->R[t->offset], R, count * sizeof(long long));
+   t->offset += count;
+   if (t->writer) poly_writer_append(t->writer, R, count);
+}  /* stream_sink */
@@ -0,0 +1,198 @@
+#define _DEFAULT_SOURCE /* madvise */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "poly_io.h"
+
+/* Coefficients packed per fwrite call by the writer */
+#define POLY_IO_CHUNK 65536
+
+static int valid_width(uint32_t width) {
+    return width == 1 || width == 2 || width == 4 || width == 8 || width == 16;
+}
+
+/* Reads the little-endian WIDTH-byte signed integer at P (x86 is little-endian, so this is a sign-extending load) */
+static inline long long load_coeff(const unsigned char *p, int width) {
+    switch (width) {
+        case 1:  { int8_t  v; memcpy(&v, p, 1); return v; }
+        case 2:  { int16_t v; memcpy(&v, p, 2); return v; }
+        default: { int32_t v; memcpy(&v, p, 4); return v; }
+    }
+}
+
+void poly_map_open(const char *path, int thread_count, struct poly_map *pm) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        exit(EXIT_FAILURE);
+    }
+
+    struct poly_header h;
+    if ((size_t) st.st_size < sizeof(h) || pread(fd, &h, sizeof(h), 0) != (ssize_t) sizeof(h)
+            || memcmp(h.magic, POLY_MAGIC, 4) != 0 || !valid_width(h.width)) {
+        fprintf(stderr, "%s: not a polynomial file\n", path);
+        exit(EXIT_FAILURE);
+    }
+    if (h.width == 16) {
+        fprintf(stderr, "%s: 128-bit coefficients cannot be used as input\n", path);
+        exit(EXIT_FAILURE);
+    }
+    /* degree < (SIZE_MAX - header) / width: the expected size below does not wrap */
+    if (h.degree >= (SIZE_MAX - sizeof(h)) / h.width || (uint64_t) st.st_size != sizeof(h) + (h.degree + 1) * h.width) {
+        fprintf(stderr, "%s: size does not match degree %llu\n", path, (unsigned long long) h.degree);
+        exit(EXIT_FAILURE);
+    }
+
+    pm->length = (size_t) st.st_size;
+    pm->base = mmap(NULL, pm->length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (pm->base == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    close(fd); /* the mapping keeps the file referenced */
+    madvise(pm->base, pm->length, MADV_SEQUENTIAL); /* the multipliers stream through the coefficients: read ahead */
+
+    pm->degree = (size_t) h.degree;
+    pm->width = (int) h.width;
+    const unsigned char *raw = (const unsigned char *) pm->base + sizeof(h);
+
+    if (h.width == 8) {
+        pm->coeffs = (const long long *) raw; /* zero copy */
+        pm->widened = NULL;
+        return;
+    }
+
+    long long *w = malloc((pm->degree + 1) * sizeof(long long));
+    if (!w) {
+        perror("malloc widened poly");
+        exit(EXIT_FAILURE);
+    }
+    if (thread_count < 1) thread_count = 1;
+    int width = pm->width;
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (size_t i = 0; i <= pm->degree; i++)
+        w[i] = load_coeff(raw + i * width, width);
+
+    pm->widened = w;
+    pm->coeffs = w;
+}
+
+void poly_map_close(struct poly_map *pm) {
+    munmap(pm->base, pm->length);
+    free(pm->widened);
+    pm->coeffs = NULL;
+    pm->widened = NULL;
+    pm->base = NULL;
+}
+
+int poly_width_for(long long bound) {
+    if (bound <= INT8_MAX)  return 1;
+    if (bound <= INT16_MAX) return 2;
+    if (bound <= INT32_MAX) return 4;
+    return 8;
+}
+
+void poly_writer_open(struct poly_writer *w, const char *path, size_t degree, int width) {
+    if (!valid_width((uint32_t) width)) {
+        fprintf(stderr, "invalid coefficient width %d\n", width);
+        exit(EXIT_FAILURE);
+    }
+    w->file = fopen(path, "wb");
+    if (!w->file) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    w->path = path;
+    w->width = width;
+    w->degree = degree;
+    w->written = 0;
+    w->buf = malloc((size_t) POLY_IO_CHUNK * width);
+    if (!w->buf) {
+        perror("malloc writer buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    struct poly_header h;
+    memcpy(h.magic, POLY_MAGIC, 4);
+    h.width = (uint32_t) width;
+    h.degree = degree;
+    if (fwrite(&h, sizeof(h), 1, w->file) != 1) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void writer_put(struct poly_writer *w, const void *data, size_t count) {
+    if (w->written + count > w->degree + 1) {
+        fprintf(stderr, "%s: more than degree+1 coefficients written\n", w->path);
+        exit(EXIT_FAILURE);
+    }
+    if (fwrite(data, (size_t) w->width, count, w->file) != count) {
+        perror(w->path);
+        exit(EXIT_FAILURE);
+    }
+    w->written += count;
+}
+
+/* Stores V as a WIDTH-byte little-endian integer at P, or exits if it does not fit */
+static inline void store_coeff(unsigned char *p, __int128 v, int width, const char *path) {
+    if (width < 16) {
+        __int128 lim = (__int128) 1 << (8*width - 1);
+        if (v < -lim || v >= lim) {
+            fprintf(stderr, "%s: coefficient does not fit %d bytes\n", path, width);
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(p, &v, (size_t) width); /* low bytes first on a little-endian machine */
+}
+
+void poly_writer_append(struct poly_writer *w, const long long *coeffs, size_t count) {
+    if (w->width == 8) { /* already in file layout */
+        writer_put(w, coeffs, count);
+        return;
+    }
+    for (size_t c0 = 0; c0 < count; c0 += POLY_IO_CHUNK) {
+        size_t len = count - c0 < POLY_IO_CHUNK ? count - c0 : POLY_IO_CHUNK;
+        for (size_t i = 0; i < len; i++)
+            store_coeff(w->buf + i * w->width, coeffs[c0 + i], w->width, w->path);
+        writer_put(w, w->buf, len);
+    }
+}
+
+void poly_writer_append_wide(struct poly_writer *w, const __int128 *coeffs, size_t count) {
+    if (w->width == 16) {
+        writer_put(w, coeffs, count);
+        return;
+    }
+    for (size_t c0 = 0; c0 < count; c0 += POLY_IO_CHUNK) {
+        size_t len = count - c0 < POLY_IO_CHUNK ? count - c0 : POLY_IO_CHUNK;
+        for (size_t i = 0; i < len; i++)
+            store_coeff(w->buf + i * w->width, coeffs[c0 + i], w->width, w->path);
+        writer_put(w, w->buf, len);
+    }
+}
+
+void poly_writer_close(struct poly_writer *w) {
+    if (w->written != w->degree + 1) {
+        fprintf(stderr, "%s: %zu coefficients written, expected %zu\n", w->path, w->written, w->degree + 1);
+        exit(EXIT_FAILURE);
+    }
+    if (fclose(w->file) != 0) {
+        perror(w->path);
+        exit(EXIT_FAILURE);
+    }
+    free(w->buf);
+    w->file = NULL;
+    w->buf = NULL;
+}
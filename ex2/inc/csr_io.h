@@ -0,0 +1,64 @@
+#ifndef csr_io_h_
+#define csr_io_h_
+
+#include <stddef.h> /* defines size_t */
+#include <stdint.h>
+
+#include "sparse_matrix_csr.h"
+
+/* Reads a Matrix Market coordinate file (.mtx) into a CSR matrix, parsing with THREAD_COUNT threads.
+ * Fields: integer, real (rounded to the nearest int with the int32 value type) and pattern (values 1).
+ * Symmetries: general, symmetric and skew-symmetric (the mirrored entries are added). Complex matrices, dense
+ * (array) files and non-square matrices are rejected. Columns are sorted in every row. Exits on any error.
+ * Returns the number of non-zeros. */
+long long read_mtx_csr(const char *path, int thread_count, struct sparse_matrix_csr *output_mtx_csr);
+
+/* Binary CSR file: a 64-byte header, then row_ptr (rows+1 int64), col_index (nnz int64) and values (nnz value_t),
+ * each section starting at a multiple of CSR_FILE_ALIGN bytes. The arrays have the in-memory layout of
+ * sparse_matrix_csr on a little-endian 64-bit machine, so a mapping of the file is used as is. */
+#define CSR_FILE_MAGIC "CSRBIN01"
+#define CSR_FILE_ALIGN 64
+
+/* Value type recorded in the header. The mixed type stores floats, so its files are those of the float type. */
+#if VALUE_TYPE == VALUE_MIXED
+#define CSR_FILE_VALUE_TYPE VALUE_FLOAT
+#else
+#define CSR_FILE_VALUE_TYPE VALUE_TYPE
+#endif
+
+struct csr_file_header {
+    char magic[8];
+    uint64_t rows;
+    uint64_t nnz;
+    uint64_t row_ptr_offset;
+    uint64_t col_index_offset;
+    uint64_t values_offset;
+    uint32_t index_width;   /* 8 */
+    uint32_t value_width;   /* sizeof(value_t) */
+    uint32_t value_type;    /* CSR_FILE_VALUE_TYPE, 0 (int32) in files written before the value type was selectable */
+    uint32_t reserved;
+};
+
+/* A binary CSR file mapped in memory. csr points into the mapping (read-only): it must not be modified nor freed
+ * with free_csr_matrix, but caches (partitions, plans) can be attached to it as to any other matrix. */
+struct csr_map {
+    struct sparse_matrix_csr csr;
+    void *base;
+    size_t length;
+};
+
+/* Returns 1 if the file at PATH starts with CSR_FILE_MAGIC, 0 otherwise (or if it cannot be read). */
+int is_csr_file(const char *path);
+
+/* Writes MTX_CSR to PATH in the binary CSR format. Exits on error. */
+void write_csr_file(const char *path, const struct sparse_matrix_csr *mtx_csr);
+
+/* Maps the binary CSR file at PATH, without copying. The header sections are bounds-checked, then THREAD_COUNT threads
+ * check that row_ptr is monotonic and every column index is in [0, rows), which reads the whole matrix once.
+ * Exits on error. */
+void csr_map_open(const char *path, int thread_count, struct csr_map *cm);
+
+/* Frees the caches attached to the mapped matrix and unmaps the file. */
+void csr_map_close(struct csr_map *cm);
+
+#endif
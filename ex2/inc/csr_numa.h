@@ -0,0 +1,37 @@
+#ifndef csr_numa_h_
+#define csr_numa_h_
+
+#include <stddef.h> /* defines size_t */
+
+#include "sparse_matrix_csr.h"
+
+/* Largest number of NUMA nodes reported */
+#define NUMA_MAX_NODES 64
+
+/* Moves the arrays of MTX_CSR to new memory written (first touched) with the static row schedule of
+ * matvecs_csr_parallel with THREAD_COUNT threads: the pages of the rows a thread multiplies are placed on its NUMA node.
+ * build_csr_matrix_two_pass and gen_sparse_matrix_csr already write the arrays that way; build_csr_matrix (one thread)
+ * and build_csr_matrix_parallel (other layout) do not. Only for matrices owning their arrays (not a csr_map).
+ * Returns 1 on success, 0 if memory cannot be allocated (the matrix is then unchanged). */
+int csr_first_touch(struct sparse_matrix_csr *mtx_csr, int thread_count);
+
+/* Pins thread t of the parallel regions of THREAD_COUNT threads to one CPU of the process affinity mask, the threads
+ * being spread evenly over the mask (as OMP_PROC_BIND=spread), so that they cover all the sockets.
+ * The OpenMP runtime reuses its threads for later regions (as libgomp does), which keep the pinning; setting
+ * OMP_PROC_BIND and OMP_PLACES before the program starts is the portable equivalent.
+ * Returns the number of threads pinned. */
+int numa_pin_threads(int thread_count);
+
+/* Sets node[t] to the NUMA node thread t of a parallel region of THREAD_COUNT threads runs on (-1 if unknown).
+ * Returns the number of nodes seen (largest node + 1). */
+int numa_thread_nodes(int thread_count, int *node);
+
+/* Adds to per_node[n] the number of pages of [p, p + bytes) resident on node n (per_node has NUMA_MAX_NODES entries).
+ * Pages never touched are not counted. Returns the number of pages found resident, or -1 if the kernel cannot tell. */
+long long numa_page_nodes(const void *p, size_t bytes, long long *per_node);
+
+/* Bytes moved by one multiplication of the rows [lo, hi) of A: values and column indices, row pointers,
+ * one read of x per non-zero and one write of the result per row. */
+double csr_spmv_bytes(const struct sparse_matrix_csr *A, long long lo, long long hi);
+
+#endif
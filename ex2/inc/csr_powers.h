@@ -0,0 +1,53 @@
+#ifndef csr_powers_h_
+#define csr_powers_h_
+
+#include "sparse_matrix_csr.h"
+
+/* Bytes of matrix and vectors a block of the matrix-powers kernel should fit in. 0 (default): the share of one thread
+ * of the last-level cache, as reported by sysconf, or 1 MiB if unknown. Can be set at compile time with -DCSR_POWERS_CACHE_BYTES=... */
+#ifndef CSR_POWERS_CACHE_BYTES
+#define CSR_POWERS_CACHE_BYTES 0
+#endif
+
+/* Largest accepted amount of redundant work: a plan with s steps is used only if its blocks, ghost rows included,
+ * multiply at most CSR_POWERS_MAX_REDUNDANCY * s * nnz elements per round. Otherwise a smaller s is tried. */
+#define CSR_POWERS_MAX_REDUNDANCY 1.5
+
+/* One block of the matrix-powers plan: the contiguous rows [row_lo, row_lo + count[s]) it owns, and the ghost rows
+ * needed to compute s powers on them without reading other blocks.
+ * Local index l stands for row ids[l] of the matrix. Local indices are sorted by decreasing level: the level of a row
+ * is the last step at which its value is needed (s for the owned rows, which come first and in order; 0 for rows
+ * only read from the input vector). count[j] is the number of local rows of level >= j, so step k of a round of s
+ * steps computes the local rows [0, count[k]).
+ * row_ptr, col and values are the local CSR copy of the count[1] computed rows, with local column indices. */
+struct csr_powers_block {
+    long long row_lo;
+    long long nlocal;
+    long long *ids;
+    long long *count;
+    long long *row_ptr;
+    int *col;
+    value_t *values;
+};
+
+/* Matrix-powers plan of a CSR matrix: s multiplications per round, and the blocks computing them.
+ * s = 1 means that no s > 1 was cheap enough (for example random columns: the ghost rows cover the whole matrix)
+ * and the blocks are not built. */
+struct csr_powers_plan {
+    int nparts;           /* thread count the plan was built for */
+    int s;
+    long long nblocks;
+    struct csr_powers_block *blocks;
+    long long max_local;  /* largest nlocal, the size of the per-thread local vectors */
+    long long work;       /* elements multiplied per round of s steps, ghost rows included */
+};
+
+/* Builds (in parallel) the matrix-powers plan of MTX_CSR for rounds of S multiplications and THREAD_COUNT threads.
+ * The plan may use fewer steps per round than S, see above. It copies the rows it needs and does not refer to
+ * MTX_CSR afterwards, but is only valid for MTX_CSR as it is now. Exits if memory cannot be allocated. */
+struct csr_powers_plan *csr_powers_plan_create(struct sparse_matrix_csr *mtx_csr, int s, int thread_count);
+
+/* Frees a plan (NULL is accepted). */
+void free_csr_powers_plan(struct csr_powers_plan *plan);
+
+#endif
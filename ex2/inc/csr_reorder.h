@@ -0,0 +1,31 @@
+#ifndef csr_reorder_h_
+#define csr_reorder_h_
+
+#include "sparse_matrix_csr.h"
+
+/* A CSR matrix with symmetrically permuted rows and columns, B = P A P^T: row i of B is row perm[i] of A,
+ * and column perm[j] of A is column j of B (iperm[perm[i]] = i). Multiplying B with the permuted x gives the permuted A x. */
+struct csr_reordered {
+    struct sparse_matrix_csr *mtx;
+    long long *perm;
+    long long *iperm;
+};
+
+/* Reverse Cuthill-McKee ordering of the square matrix MTX_CSR: breadth-first search from a pseudo-peripheral row of
+ * every connected component, visiting the neighbors by increasing degree, then reversed.
+ * The graph is the pattern of A + A^T, so that unsymmetric matrices are handled. If SYMMETRIC is set, the pattern
+ * of A is assumed symmetric and used alone, which skips the transposition (the most expensive part of the search).
+ * Returns perm (perm[new] = old), allocated with malloc. */
+long long *csr_rcm_permutation(struct sparse_matrix_csr *mtx_csr, int symmetric);
+
+/* Builds P A P^T for the permutation PERM (perm[new] = old) with THREAD_COUNT threads. Takes ownership of PERM. 
+ * Column indices stay sorted in every row. */
+struct csr_reordered csr_permute(struct sparse_matrix_csr *mtx_csr, long long *perm, int thread_count);
+
+/* Frees the permuted matrix and the permutation vectors. */
+void free_csr_reordered(struct csr_reordered *R);
+
+/* Bandwidth of a CSR matrix: the largest |i - j| over its non-zeros (i, j). */
+long long csr_bandwidth(const struct sparse_matrix_csr *mtx_csr);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef csr_spmv_plan_h_
+#define csr_spmv_plan_h_
+
+#include "sparse_matrix_csr.h"
+
+/* Reusable execution context of repeated CSR multiplications, for callers that multiply by the same matrix many times
+ * with few multiplications per call (e.g. a solver loop). Everything matvecs_csr_parallel sets up on every call is
+ * done once here: the row partition (equal work, as csr_row_partition) and the ping-pong vectors, first touched by the
+ * thread that owns each row range so that they are allocated on its memory node.
+ * The plan refers to A without owning it: A must outlive the plan and not change. */
+struct csr_spmv_plan {
+    const struct sparse_matrix_csr *A;
+    int nparts;             /* thread count the plan was built for */
+    long long *row_start;   /* part p computes rows [row_start[p], row_start[p+1]) */
+    vec_t *x_tmp[2];        /* ping-pong vectors of the intermediate multiplications */
+};
+
+/* Builds the plan of MTX_CSR for THREAD_COUNT threads. Exits if memory cannot be allocated. */
+struct csr_spmv_plan *csr_spmv_plan_create(struct sparse_matrix_csr *mtx_csr, int thread_count);
+
+/* Frees a plan (NULL is accepted). */
+void free_csr_spmv_plan(struct csr_spmv_plan *plan);
+
+/* res = A^ITERS x, with the interface of matvecs_csr_parallel (ITERS = 0 copies x) and the thread count of the plan.
+ * Nothing is allocated and nothing is copied: the first multiplication reads x and the last one writes res directly.
+ * x and res must not overlap. */
+void csr_spmv_execute(struct csr_spmv_plan *plan, const vec_t *x, vec_t *res, int iters);
+
+/* Same as csr_spmv_execute, called by every thread of an enclosing parallel region instead of opening its own:
+ * a caller looping over many multiplications keeps one team for the whole loop. The work is shared with orphaned
+ * omp for loops, and all the threads return after res is complete. */
+void csr_spmv_execute_team(struct csr_spmv_plan *plan, const vec_t *x, vec_t *res, int iters);
+
+#endif
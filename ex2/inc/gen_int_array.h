@@ -1,7 +1,9 @@
 #ifndef gen_int_array_h_
 #define gen_int_array_h_
 
-/* Allocates an array of SIZE integers, fills it with random values, and returns a pointer to it */
-int *gen_int_array(long long size, int max_val);
+#include "value_type.h"
+
+/* Allocates a vector of SIZE elements, fills it with random integer values in [1, max_val], and returns a pointer to it */
+vec_t *gen_int_array(long long size, int max_val);
 
 #endif
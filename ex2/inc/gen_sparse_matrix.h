@@ -2,10 +2,20 @@
 #define gen_sparse_matrix_h_
 
 #include "xorshift32.h" /* PRNG by George Marsaglia */
+#include "sparse_matrix_csr.h"
 
-/* Allocates memory for matrix, fills it with random integers with given sparsity, and returns a double pointer to it (pointer to rows).
+/* Allocates memory for matrix, fills it with random integer values (of type value_t) with given sparsity, and returns a double pointer to it (pointer to rows).
 Also, assigns the input variable NNZ to the number of non-zero elements generated. 
-If max_val is less than 2, RAND_MAX is used instead. */
-int **gen_sparse_matrix(long long rows, long long cols, float sparsity, int max_val, int thread_count, struct xorshift32_state *state, long long *nnz);
+If max_val is less than 2, RAND_MAX is used instead.
+With a floating-point value type, every row is then scaled to sum 1, so that repeated multiplications stay in range. */
+value_t **gen_sparse_matrix(long long rows, long long cols, float sparsity, int max_val, int thread_count, struct xorshift32_state *state, long long *nnz);
+
+/* Generates a random sparse matrix of the same family as gen_sparse_matrix (every element is non-zero with
+probability 1-sparsity, values uniform in [1, max_val], rows scaled to sum 1 for floating-point types) directly into OUTPUT_MTX_CSR, without the dense
+rows x cols array: memory and time are proportional to the number of non-zeros.
+Each row draws its own random stream from the seed in STATE and its index, so the matrix does not depend on
+THREAD_COUNT. Row counts are generated first, row_ptr is built with a parallel prefix sum, and then
+col_index and values are filled in parallel. Returns the number of non-zero elements. */
+long long gen_sparse_matrix_csr(long long rows, long long cols, float sparsity, int max_val, int thread_count, struct xorshift32_state *state, struct sparse_matrix_csr *output_mtx_csr);
 
 #endif
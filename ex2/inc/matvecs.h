@@ -1,15 +1,30 @@
 #ifndef matvecs_h_
 #define matvecs_h_
 
+#include "value_type.h"
+
 /* Repeated matrix-vector multiplication.
 A is the input matrix. Matrix has to be square.
 x is the input vector. 
 res is the output vector. It should be pre-allocated. 
 SIZE is the number of rows or columns of the matrix, and also the number of elements of the vector and each resultant vector. 
 ITERS is the number of repeated multiplications. If 0, returns the input vector. */
-void matvecs(int **A, int *x, int *res, long long size, int iters);
+void matvecs(value_t **A, vec_t *x, vec_t *res, long long size, int iters);
 
 /* Same as matvecs but in parallel, with THREAD_COUNT threads. */
-void matvecs_parallel(int **A, int *x, int *res, long long size, int iters, int thread_count);
+void matvecs_parallel(value_t **A, vec_t *x, vec_t *res, long long size, int iters, int thread_count);
+
+/* Rows multiplied together by the vector kernels of matvecs_dense: each load of x is shared by this many rows. */
+#define MATVECS_DENSE_ROWS 4
+
+/* Name of the kernel used by matvecs_dense ("avx512", "avx2" or "scalar", always scalar for other types than int32). */
+const char *matvecs_dense_isa(void);
+
+/* Same as matvecs_parallel, with A stored contiguously in row-major order (A[i*size + j], the backing buffer of
+the matrices of gen_sparse_matrix) and a vector kernel multiplying MATVECS_DENSE_ROWS rows at a time.
+Every element of a step depends on all the elements of the previous step, so steps cannot be fused for a dense matrix:
+all the steps run in one parallel region, each thread keeping the same rows, which stay in its cache between steps
+when they fit. */
+void matvecs_dense(const value_t *A, vec_t *x, vec_t *res, long long size, int iters, int thread_count);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef matvecs_bcsr_h_
+#define matvecs_bcsr_h_
+
+#include "sparse_matrix_bcsr.h"
+
+/* Returns 1 if r x c blocks have an unrolled kernel (the BCSR_BLOCK_SIZES), 0 if they use the generic one. */
+int matvecs_bcsr_unrolled(int r, int c);
+
+/* Repeated matrix-vector multiplication using the block CSR representation.
+Same interface as matvecs_csr: A is square, res is pre-allocated with A->rows elements,
+ITERS is the number of repeated multiplications. If 0, returns the input vector. */
+void matvecs_bcsr(struct sparse_matrix_bcsr *A, vec_t *x, vec_t *res, int iters);
+
+/* Same as matvecs_bcsr but in parallel, with THREAD_COUNT threads sharing the block rows. */
+void matvecs_bcsr_parallel(struct sparse_matrix_bcsr *A, vec_t *x, vec_t *res, int iters, int thread_count);
+
+#endif
@@ -2,6 +2,8 @@
 #define matvecs_csr_h_
 
 #include "sparse_matrix_csr.h"
+#include "csr_reorder.h"
+#include "csr_powers.h"
 
 /* Repeated matrix-vector multiplication using CSR sparse matrix representation.
 A is the input matrix. Matrix has to be square.
@@ -9,9 +11,31 @@ x is the input vector.
 res is the output vector. It should be pre-allocated. 
 SIZE is the number of rows or columns of the matrix, and also the number of elements of the vector and each resultant vector. 
 ITERS is the number of repeated multiplications. If 0, returns the input vector. */
-void matvecs_csr(struct sparse_matrix_csr *A_csr, int *x, int *res, int iters);
+void matvecs_csr(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters);
 
 /* Same as matvecs but in parallel, with THREAD_COUNT threads. */
-void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, int *x, int *res, int iters, int thread_count);
+void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters, int thread_count);
+
+/* Same as matvecs_csr_parallel, but each thread gets a contiguous range of rows with about the same number of non-zeros
+(csr_row_partition, computed once and kept in A_csr), instead of the same number of rows. */
+void matvecs_csr_balanced(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters, int thread_count);
+
+/* Same as matvecs_csr_parallel, with the merge-path partition (csr_merge_partition): every thread gets the same
+number of rows plus non-zeros, rows longer than a share are split between threads, and the partial sums of the
+split rows are added after each multiplication. */
+void matvecs_csr_merge(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters, int thread_count);
+
+/* Matrix-powers variant of matvecs_csr_parallel: the rows are cut in cache-sized blocks, and each block computes
+s = PLAN->s multiplications in a row from a local copy of its rows and of the ghost rows they depend on. PLAN is built
+for A_csr by csr_powers_plan_create, and created and freed by the caller so that it is reused across calls.
+The matrix is then read from memory once per s multiplications, and threads synchronize once per s multiplications,
+at the cost of recomputing the ghost rows. If the ghost rows are too many (e.g. random column patterns), the plan
+fuses fewer steps, down to plain matvecs_csr_parallel. */
+void matvecs_csr_powers(struct sparse_matrix_csr *A_csr, const struct csr_powers_plan *plan, vec_t *x, vec_t *res, int iters, int thread_count);
+
+/* matvecs_csr_parallel on a reordered matrix (csr_permute), with the permutation applied transparently:
+x is permuted on the way in and the result permuted back on the way out, once for all the ITERS multiplications,
+so that x and res are in the original order. */
+void matvecs_csr_reordered(struct csr_reordered *R, vec_t *x, vec_t *res, int iters, int thread_count);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef matvecs_csr_compact_h_
+#define matvecs_csr_compact_h_
+
+#include "sparse_matrix_csr_compact.h"
+
+/* Repeated matrix-vector multiplication using the compact CSR representation (either encoding).
+Same interface as matvecs_csr: A is square, res is pre-allocated with A->rows elements,
+ITERS is the number of repeated multiplications. If 0, returns the input vector. 
+With the delta encoding the columns are decoded on the fly, row by row, inside the multiplication loop. */
+void matvecs_csr_compact(struct sparse_matrix_csr_compact *A, vec_t *x, vec_t *res, int iters);
+
+/* Same as matvecs_csr_compact but in parallel, with THREAD_COUNT threads. */
+void matvecs_csr_compact_parallel(struct sparse_matrix_csr_compact *A, vec_t *x, vec_t *res, int iters, int thread_count);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef matvecs_csr_sym_h_
+#define matvecs_csr_sym_h_
+
+#include "sparse_matrix_csr_sym.h"
+
+/* Repeated matrix-vector multiplication using the symmetric CSR representation (upper triangle only).
+Same interface as matvecs_csr: res is pre-allocated with A->rows elements,
+ITERS is the number of repeated multiplications. If 0, returns the input vector. 
+Each stored element a_ij is read once and used twice: y_i += a_ij x_j and, off the diagonal, y_j += a_ij x_i. */
+void matvecs_csr_sym(struct sparse_matrix_csr_sym *A, vec_t *x, vec_t *res, int iters);
+
+/* Same as matvecs_csr_sym but in parallel, with THREAD_COUNT threads (csr_sym_partition). The mirrored contributions
+of a part to rows below its own range, the only ones other threads also write, go to a private vector covering
+[part end, part_col_end), added to the result rows by their owners after each multiplication. */
+void matvecs_csr_sym_parallel(struct sparse_matrix_csr_sym *A, vec_t *x, vec_t *res, int iters, int thread_count);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef matvecs_sell_h_
+#define matvecs_sell_h_
+
+#include "sparse_matrix_sell.h"
+
+/* Slice height that fills one vector register of the best instruction set of this CPU:
+16 with AVX-512 (16 int lanes), 8 otherwise (AVX2, and a reasonable unroll for the scalar kernel). */
+int matvecs_sell_default_c(void);
+
+/* Name of the kernel used for slices of height C ("avx512", "avx2" or "scalar"). 
+Vector kernels exist for C = 8 (AVX2, or AVX-512) and C = 16 (AVX-512), any other C uses the scalar kernel. */
+const char *matvecs_sell_isa(int C);
+
+/* Repeated matrix-vector multiplication using the SELL-C-sigma sparse matrix representation.
+Same interface as matvecs_csr: A_sell is square, res is pre-allocated with A_sell->rows elements,
+ITERS is the number of repeated multiplications. If 0, returns the input vector. */
+void matvecs_sell(struct sparse_matrix_sell *A_sell, vec_t *x, vec_t *res, int iters);
+
+/* Same as matvecs_sell but in parallel, with THREAD_COUNT threads. Slices are handed out dynamically,
+since sorting makes the first slices of every sigma window the widest. */
+void matvecs_sell_parallel(struct sparse_matrix_sell *A_sell, vec_t *x, vec_t *res, int iters, int thread_count);
+
+#endif
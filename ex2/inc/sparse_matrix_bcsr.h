@@ -0,0 +1,47 @@
+#ifndef sparse_matrix_bcsr_h_
+#define sparse_matrix_bcsr_h_
+
+#include "sparse_matrix_csr.h"
+
+/* Block sizes with an unrolled multiplication kernel, as pairs r0, c0, r1, c1, ... Other sizes use a generic loop. */
+#define BCSR_BLOCK_SIZES { 1,1, 1,2, 2,1, 2,2, 3,3, 4,1, 1,4, 2,4, 4,2, 4,4, 8,1 }
+#define BCSR_NUM_BLOCK_SIZES 11
+
+/* Struct that holds a sparse matrix in block CSR format: the matrix is cut in dense r x c blocks, and the blocks
+ * that contain at least one non-zero are stored like the non-zeros of CSR, with one column index per block.
+ * Block row b covers rows [b*r, b*r + r); its blocks are brow_ptr[b] to brow_ptr[b+1]-1, sorted by block column.
+ * Block k covers columns [bcol[k]*c, bcol[k]*c + c), its r*c values are values[k*r*c ...], row-major, zeros included.
+ * The last block row and column may extend past the matrix, their extra entries are 0.
+ */
+struct sparse_matrix_bcsr {
+    long long rows;
+    int r;
+    int c;
+    long long brows;     /* number of block rows, ceil(rows/r) */
+    long long nblocks;
+    long long nnz;       /* non-zeros of the matrix (the stored values are nblocks*r*c) */
+    long long *brow_ptr;
+    int *bcol;
+    value_t *values;
+};
+
+/* Creates a new sparse_matrix_bcsr object, initializes its fields, and returns it. Value fields are set to 0, and pointer fields to NULL. */
+struct sparse_matrix_bcsr init_bcsr_matrix(void);
+
+/* Builds the r x c block representation of a square CSR matrix with THREAD_COUNT threads.
+ * Returns 1 on success, 0 if r or c is not positive or the block columns do not fit an int. */
+int build_bcsr_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_bcsr *output_mtx_bcsr, int r, int c, int thread_count);
+
+/* Estimates the fill ratio (stored values / non-zeros, >= 1) of the r x c block representation of MTX_CSR,
+ * by counting the blocks of about FRACTION of the block rows, evenly spaced (FRACTION >= 1: exact). */
+double bcsr_estimate_fill(struct sparse_matrix_csr *mtx_csr, int r, int c, double fraction, int thread_count);
+
+/* Picks the block size of MTX_CSR among the BCSR_BLOCK_SIZES, from the estimated fill
+ * ratios: the chosen size minimizes the bytes moved per non-zero, fill * (value + index / (r*c)).
+ * 1x1 (plain CSR with int indices) is chosen when no block size pays off. Returns the estimated fill of the choice. */
+double bcsr_choose_block(struct sparse_matrix_csr *mtx_csr, int *r, int *c, int thread_count);
+
+/* Frees the arrays of the sparse_matrix_bcsr struct and resets its fields. */
+void free_bcsr_matrix(struct sparse_matrix_bcsr *mtx_bcsr);
+
+#endif
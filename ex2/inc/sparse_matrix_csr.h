@@ -1,31 +1,64 @@
 #ifndef sparse_matrix_csr_h_
 #define sparse_matrix_csr_h_
 
+#include "value_type.h"
+
+/* Work partition of a CSR matrix among NPARTS threads. Part p covers rows [row_start[p], row_start[p+1]).
+ * For a merge-path partition, part p also starts at non-zero nz_start[p], possibly in the middle of its first row,
+ * and ends at nz_start[p+1] (in the middle of row row_start[p+1], whose remaining non-zeros belong to the next part).
+ * nz_start is NULL for a row partition. */
+struct csr_partition {
+    int nparts;
+    long long *row_start;
+    long long *nz_start;
+};
+
 /* Struct that holds the pointers to the arrays of the CSR sparse matrix representation. 
  * Also holds the number of rows in the rows field. 
  * Fields: rows, values, col_index, row_ptr. 
+ * row_part and merge_part cache the partitions computed by csr_row_partition and csr_merge_partition (NULL until then),
+ * so that repeated multiplications compute them only once.
  */
 struct sparse_matrix_csr { 
     long long rows;
-    int *values;
+    value_t *values;
     long long *col_index;
     long long *row_ptr;
+    struct csr_partition *row_part;
+    struct csr_partition *merge_part;
 };
 
 /* Creates a new sparse_matrix_csr object, initializes its fields, and returns it. Value fields are set to 0, and pointer fields to NULL. */
 struct sparse_matrix_csr init_csr_matrix(void);
 
 /* Buils the CSR sparse matrix representation of the input matrix. NNZ required. */
-int build_csr_matrix(int **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz);
+int build_csr_matrix(value_t **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz);
 
 /* Buils the CSR sparse matrix representation of the input matrix in parallel. NNZ required. */
-int build_csr_matrix_parallel(int **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz, size_t thread_count);
+int build_csr_matrix_parallel(value_t **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz, size_t thread_count);
+
+/* Buils the CSR sparse matrix representation of the input matrix in parallel, in two passes over the matrix:
+ * the non-zeros of every row are counted, row_ptr is the exclusive scan of the counts, then each thread writes
+ * col_index and values of its rows directly at their final positions. No per-thread copy of the matrix is needed.
+ * NNZ is counted, not required. Returns 1 on success, 0 if the arrays cannot be allocated. */
+int build_csr_matrix_two_pass(value_t **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, size_t thread_count);
+
+/* Returns the partition of the rows of MTX_CSR into NPARTS contiguous ranges of about equal work (non-zeros plus rows),
+ * computed from row_ptr with binary searches on the first call and cached in the struct. */
+const struct csr_partition *csr_row_partition(struct sparse_matrix_csr *mtx_csr, int nparts);
+
+/* Returns the merge-path partition of MTX_CSR into NPARTS parts: the merge of row ends and non-zeros (rows + nnz steps)
+ * is cut in equal pieces, so long rows are split between parts. Computed on the first call and cached in the struct. */
+const struct csr_partition *csr_merge_partition(struct sparse_matrix_csr *mtx_csr, int nparts);
 
 /* Frees the pointers associated with the sparse_matrix_csr struct. */
 void free_csr_matrix(struct sparse_matrix_csr *mtx_csr);
 
+/* Frees the partitions cached in the struct, but not the matrix arrays (for matrices that do not own them). */
+void free_csr_caches(struct sparse_matrix_csr *mtx_csr);
+
 /* Counts and returns the number of non-zero elements of a matrix. */
-long long count_nnz(int **mtx, long long rows, long long cols);
+long long count_nnz(value_t **mtx, long long rows, long long cols);
 
 /* Compares two sparse_matrix_csr structs. Returns 1 if they are the same, 0 if not. */
 int compare_csr_matrix(struct sparse_matrix_csr *A, struct sparse_matrix_csr *B, long long nnz);
@@ -0,0 +1,48 @@
+#ifndef sparse_matrix_csr_compact_h_
+#define sparse_matrix_csr_compact_h_
+
+#include <stdint.h>
+
+#include "sparse_matrix_csr.h"
+
+/* Column index encodings of the compact CSR format */
+enum csr_compact_encoding {
+    CSR_COMPACT_U32,   /* 32-bit column indices: 8 bytes per non-zero with the value */
+    CSR_COMPACT_DELTA  /* per-row deltas between consecutive columns, 1, 2 or 4 bytes each */
+};
+
+/* Struct that holds a sparse matrix in CSR form with smaller column indices (the long long indices of sparse_matrix_csr
+ * make each non-zero cost 12 bytes of memory traffic).
+ * Fields common to both encodings: rows, nnz, values, row_ptr (same as sparse_matrix_csr).
+ * CSR_COMPACT_U32:   col_index holds the column of every non-zero.
+ * CSR_COMPACT_DELTA: row i starts at column row_base[i]; each next column is the previous one plus a delta.
+ *                    The len-1 deltas of row i are stored from byte delta_ptr[i] of deltas, row_width[i] bytes each,
+ *                    the smallest width holding the largest delta of the row. Columns must be sorted inside rows.
+ */
+struct sparse_matrix_csr_compact {
+    long long rows;
+    long long nnz;
+    enum csr_compact_encoding encoding;
+    value_t *values;
+    long long *row_ptr;
+    uint32_t *col_index;      /* U32 only */
+    uint32_t *row_base;       /* DELTA only */
+    uint8_t *row_width;       /* DELTA only */
+    long long *delta_ptr;     /* DELTA only, rows+1 byte offsets */
+    uint8_t *deltas;          /* DELTA only */
+};
+
+/* Creates a new sparse_matrix_csr_compact object, initializes its fields, and returns it. Value fields are set to 0, and pointer fields to NULL. */
+struct sparse_matrix_csr_compact init_csr_compact_matrix(void);
+
+/* Builds the compact representation of a square CSR matrix with the given ENCODING, using THREAD_COUNT threads.
+ * Returns 1 on success, 0 if the columns do not fit 32 bits, or (delta encoding) if the columns of a row are not sorted. */
+int build_csr_compact_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_csr_compact *output_mtx, enum csr_compact_encoding encoding, int thread_count);
+
+/* Bytes used by the column indices (including row_base, row_width and delta_ptr for the delta encoding). */
+long long csr_compact_index_bytes(const struct sparse_matrix_csr_compact *mtx);
+
+/* Frees the arrays of the sparse_matrix_csr_compact struct and resets its fields. */
+void free_csr_compact_matrix(struct sparse_matrix_csr_compact *mtx);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef sparse_matrix_csr_sym_h_
+#define sparse_matrix_csr_sym_h_
+
+#include "sparse_matrix_csr.h"
+
+/* Struct that holds a symmetric sparse matrix in CSR form, with only the upper triangle and the diagonal stored
+ * (columns >= row in every row, sorted, the diagonal element first when present): about half the memory and traffic
+ * of sparse_matrix_csr. Each stored element a_ij with j > i also stands for a_ji.
+ * Fields: rows, nnz (non-zeros of the full matrix), values, col_index, row_ptr (of the stored triangle).
+ * nparts, part_start and part_col_end cache the partition of the parallel kernel (csr_sym_partition, NULL until then):
+ * part p owns rows [part_start[p], part_start[p+1]), and its rows have no column at or beyond part_col_end[p].
+ */
+struct sparse_matrix_csr_sym {
+    long long rows;
+    long long nnz;
+    value_t *values;
+    long long *col_index;
+    long long *row_ptr;
+    int nparts;
+    long long *part_start;
+    long long *part_col_end;
+};
+
+/* Creates a new sparse_matrix_csr_sym object, initializes its fields, and returns it. Value fields are set to 0, and pointer fields to NULL. */
+struct sparse_matrix_csr_sym init_csr_sym_matrix(void);
+
+/* Builds the symmetric representation of the square CSR matrix MTX_CSR (columns sorted in every row) with THREAD_COUNT threads.
+ * CHECK = 1: returns 0 (nothing built) unless MTX_CSR is symmetric, a_ji == a_ij for every element.
+ * CHECK = 0: the matrix built is the symmetric matrix with the upper triangle of MTX_CSR, its lower triangle is ignored.
+ * Returns 1 on success. */
+int build_csr_sym_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_csr_sym *output_mtx, int check, int thread_count);
+
+/* Builds the full CSR matrix (both triangles, columns sorted) of the symmetric matrix MTX. */
+void expand_csr_sym_matrix(const struct sparse_matrix_csr_sym *mtx, struct sparse_matrix_csr *output_mtx_csr);
+
+/* Returns the number of parts of the partition of MTX for NPARTS threads: contiguous row ranges of about equal work
+ * (stored elements plus rows), with the column extent of each range. Computed on the first call and cached in the struct. */
+int csr_sym_partition(struct sparse_matrix_csr_sym *mtx, int nparts);
+
+/* Frees the arrays of the sparse_matrix_csr_sym struct and resets its fields. */
+void free_csr_sym_matrix(struct sparse_matrix_csr_sym *mtx);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef sparse_matrix_sell_h_
+#define sparse_matrix_sell_h_
+
+#include "sparse_matrix_csr.h"
+
+/* Largest supported slice height C */
+#define SELL_MAX_C 64
+
+/* Struct that holds a sparse matrix in SELL-C-sigma format (sliced ELLPACK with sorting window sigma).
+ * The rows are sorted by decreasing length inside windows of sigma rows, then cut in slices of C consecutive rows.
+ * Each slice is padded to its longest row and stored column-major: element k of row l of slice s is at
+ * slice_ptr[s] + k*C + l, so the C rows of a slice are processed together in the lanes of a vector.
+ * Padding has value 0 and column index 0.
+ * perm[i] is the original row of sorted row i (-1 for the padding rows of the last slice).
+ * Column indices are 32 bits wide, as needed by the gather instructions.
+ */
+struct sparse_matrix_sell {
+    long long rows;
+    int C;
+    long long sigma;      /* window actually used: a multiple of C, at most the padded row count */
+    long long nslices;
+    long long nnz;
+    long long *slice_ptr; /* nslices+1 offsets, slice_ptr[nslices] is the stored size including padding */
+    value_t *values;
+    int *col_index;
+    long long *perm;
+};
+
+/* Creates a new sparse_matrix_sell object, initializes its fields, and returns it. Value fields are set to 0, and pointer fields to NULL. */
+struct sparse_matrix_sell init_sell_matrix(void);
+
+/* Builds the SELL-C-sigma representation of a square CSR matrix with THREAD_COUNT threads. SIGMA is rounded up to a multiple of C
+ * (SIGMA = C: rows are only sorted inside their slice, SIGMA >= rows: global sort, for any SIGMA up to INT_MAX).
+ * Returns 1 on success, 0 if C is not in [1, SELL_MAX_C] or the column indices do not fit 32 bits. */
+int build_sell_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_sell *output_mtx_sell, int C, int sigma, int thread_count);
+
+/* Frees the arrays of the sparse_matrix_sell struct and resets its fields. */
+void free_sell_matrix(struct sparse_matrix_sell *mtx_sell);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef spmm_csr_h_
+#define spmm_csr_h_
+
+#include "sparse_matrix_csr.h"
+
+/* Sparse matrix times a block of K vectors, Y = A X. X and Y are interleaved (row-major n x K arrays):
+X[row*K + l] is entry row of vector l. Each non-zero of A is read once and updates K sums,
+vectorized with AVX-512 (16 lanes) or AVX2 (8 lanes) when the CPU has them. Y must be pre-allocated. */
+void spmm_csr(struct sparse_matrix_csr *A_csr, const vec_t *X, vec_t *Y, int k);
+
+/* Same as spmm_csr but in parallel, with THREAD_COUNT threads. */
+void spmm_csr_parallel(struct sparse_matrix_csr *A_csr, const vec_t *X, vec_t *Y, int k, int thread_count);
+
+/* Repeated multiplication of a block of K vectors, the multi-vector form of matvecs_csr: res = A^ITERS X, 
+with X and res interleaved as above. If ITERS is 0, returns the input vectors. */
+void matmuls_csr(struct sparse_matrix_csr *A_csr, vec_t *X, vec_t *res, int k, int iters);
+
+/* Same as matmuls_csr but in parallel, with THREAD_COUNT threads. */
+void matmuls_csr_parallel(struct sparse_matrix_csr *A_csr, vec_t *X, vec_t *res, int k, int iters, int thread_count);
+
+/* Name of the instruction set used by the kernels ("avx512", "avx2" or "scalar"). */
+const char *spmm_csr_isa(void);
+
+#endif
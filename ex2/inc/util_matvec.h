@@ -3,10 +3,13 @@
 
 #include <stdio.h>
 
-static long long vectors_diffs(const int* vec_a, const int* vec_b, long long size) {
+#include "value_type.h"
+
+/* Number of elements that differ (beyond the rounding tolerance of vec_close for floating-point types) */
+static long long vectors_diffs(const vec_t* vec_a, const vec_t* vec_b, long long size) {
     long long num_errors = 0;
     for (long long i = 0; i < size; i++) {
-        if (vec_a[i] != vec_b[i]) {
+        if (!vec_close(vec_a[i], vec_b[i])) {
             num_errors++;
         }
     }
@@ -14,11 +17,11 @@ static long long vectors_diffs(const int* vec_a, const int* vec_b, long long siz
 }
 
 #ifdef DEBUG
-static void print_matrix(const int **mtx, long long rows, long long cols) {
+static void print_matrix(const value_t **mtx, long long rows, long long cols) {
     long long i, j;
     for (i = 0; i < rows; i++) {
         for (j = 0; j < cols; j++) {
-            printf("%d, ", mtx[i][j]);
+            printf(VEC_FMT ", ", (vec_t) mtx[i][j]);
         }
         puts("");
     }
@@ -26,10 +29,10 @@ static void print_matrix(const int **mtx, long long rows, long long cols) {
 #endif
 
 #ifdef DEBUG
-static void print_vector(const int *vec, long long size) {
+static void print_vector(const vec_t *vec, long long size) {
     long long i;
     for (i = 0; i < size; i++) {
-        printf("%d, ", vec[i]);
+        printf(VEC_FMT ", ", vec[i]);
     }
     puts("");
 }
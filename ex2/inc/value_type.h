@@ -0,0 +1,62 @@
+#ifndef value_type_h_
+#define value_type_h_
+
+#include <math.h>
+
+/* Value types of the whole pipeline (generation, every format and kernel), chosen at compile time with
+ * -DVALUE_TYPE=... (make VALUE=int|float|double|mixed). value_t is the type of the matrix elements, vec_t the type
+ * of the vector elements and of the sums. Every kernel is written once with these types.
+ * The explicit SIMD kernels (dense, SELL, SpMM) are int32 only: with the other types the dispatch selects their scalar
+ * versions. */
+#define VALUE_INT32  1  /* int matrix and vectors, with wrapping arithmetic (default) */
+#define VALUE_FLOAT  2  /* float matrix and vectors */
+#define VALUE_DOUBLE 3  /* double matrix and vectors */
+#define VALUE_MIXED  4  /* float matrix, double vectors and sums: half the value traffic of double */
+
+#ifndef VALUE_TYPE
+#define VALUE_TYPE VALUE_INT32
+#endif
+
+#if VALUE_TYPE == VALUE_INT32
+typedef int value_t;
+typedef int vec_t;
+#define VALUE_TYPE_NAME "int32"
+#define VALUE_IS_INT 1
+#define VEC_FMT "%d"
+#define VALUE_TOLERANCE 0
+#elif VALUE_TYPE == VALUE_FLOAT
+typedef float value_t;
+typedef float vec_t;
+#define VALUE_TYPE_NAME "float"
+#define VALUE_IS_INT 0
+#define VEC_FMT "%g"
+#define VALUE_TOLERANCE 1e-3
+#elif VALUE_TYPE == VALUE_DOUBLE
+typedef double value_t;
+typedef double vec_t;
+#define VALUE_TYPE_NAME "double"
+#define VALUE_IS_INT 0
+#define VEC_FMT "%g"
+#define VALUE_TOLERANCE 1e-9
+#elif VALUE_TYPE == VALUE_MIXED
+typedef float value_t;
+typedef double vec_t;
+#define VALUE_TYPE_NAME "mixed (float matrix, double vectors)"
+#define VALUE_IS_INT 0
+#define VEC_FMT "%g"
+#define VALUE_TOLERANCE 1e-9
+#else
+#error "VALUE_TYPE must be VALUE_INT32, VALUE_FLOAT, VALUE_DOUBLE or VALUE_MIXED"
+#endif
+
+/* Whether two results of the same multiplications, with the sums done in different orders, agree:
+ * exactly for int32, within VALUE_TOLERANCE relative error for floating-point types. */
+static inline int vec_close(vec_t a, vec_t b) {
+#if VALUE_IS_INT
+    return a == b;
+#else
+    return a == b || fabs((double) a - (double) b) <= VALUE_TOLERANCE * fmax(fabs((double) a), fabs((double) b));
+#endif
+}
+
+#endif
@@ -0,0 +1,481 @@
+#define _DEFAULT_SOURCE /* madvise, strncasecmp */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "csr_io.h"
+
+/* Longest token (index or value) accepted in a .mtx data line */
+#define MTX_TOKEN_MAX 63
+/* Initial capacity (entries) of the per-chunk buffers of the parser */
+#define MTX_CHUNK_INIT 4096
+
+enum mtx_field    { MTX_INTEGER, MTX_REAL, MTX_PATTERN };
+enum mtx_symmetry { MTX_GENERAL, MTX_SYMMETRIC, MTX_SKEW };
+
+/* Entries parsed from one chunk of the data section (0-based indices, as in the file: mirrors are added later) */
+struct mtx_chunk {
+    const char *begin, *end;
+    long long count, cap;
+    long long *row, *col;
+    value_t *val;
+    long long bad_line; /* offset of the first malformed line in the file, -1 if none */
+};
+
+static void *xmalloc(size_t size, const char *what) {
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static void *map_file(const char *path, size_t *length) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        exit(EXIT_FAILURE);
+    }
+    *length = (size_t) st.st_size;
+    if (*length == 0) {
+        fprintf(stderr, "%s: empty file\n", path);
+        exit(EXIT_FAILURE);
+    }
+    void *base = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    close(fd); /* the mapping keeps the file referenced */
+    return base;
+}
+
+/* Skips blanks (not newlines) */
+static inline const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+static inline const char *next_line(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', (size_t) (end - p));
+    return nl ? nl + 1 : end;
+}
+
+/* Copies the token at P into BUF (NUL-terminated) and returns the position after it, or NULL if there is no token
+ * on the line or it is too long. The mapping is not NUL-terminated, so strtoll/strtod are only called on BUF. */
+static const char *get_token(const char *p, const char *end, char *buf) {
+    p = skip_blanks(p, end);
+    size_t len = 0;
+    while (p + len < end && p[len] != ' ' && p[len] != '\t' && p[len] != '\r' && p[len] != '\n')
+        len++;
+    if (len == 0 || len > MTX_TOKEN_MAX)
+        return NULL;
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return p + len;
+}
+
+static int parse_ll(const char *buf, long long *v) {
+    char *e;
+    *v = strtoll(buf, &e, 10);
+    return *e == '\0';
+}
+
+/* Parses the value of a data line. With the int32 value type, reals are rounded to the nearest int. */
+static int parse_value(const char *buf, enum mtx_field field, value_t *v) {
+    if (field == MTX_INTEGER) {
+        long long x;
+        if (!parse_ll(buf, &x)) return 0;
+        *v = (value_t) x;
+        return 1;
+    }
+    char *e;
+    double d = strtod(buf, &e);
+    if (*e != '\0') return 0;
+#if VALUE_IS_INT
+    *v = (value_t) lround(d);
+#else
+    *v = (value_t) d;
+#endif
+    return 1;
+}
+
+static void chunk_push(struct mtx_chunk *c, long long r, long long j, value_t v) {
+    if (c->count == c->cap) {
+        c->cap = c->cap ? 2 * c->cap : MTX_CHUNK_INIT;
+        c->row = realloc(c->row, (size_t) c->cap * sizeof(long long));
+        c->col = realloc(c->col, (size_t) c->cap * sizeof(long long));
+        c->val = realloc(c->val, (size_t) c->cap * sizeof(value_t));
+        if (!c->row || !c->col || !c->val) {
+            perror("realloc mtx chunk");
+            exit(EXIT_FAILURE);
+        }
+    }
+    c->row[c->count] = r;
+    c->col[c->count] = j;
+    c->val[c->count] = v;
+    c->count++;
+}
+
+/* Parses the data lines in [c->begin, c->end). Entries out of [1, n] or with missing tokens mark the chunk bad. */
+static void parse_chunk(struct mtx_chunk *c, const char *base, long long n, enum mtx_field field) {
+    char buf[MTX_TOKEN_MAX + 1];
+    const char *p = c->begin, *end = c->end;
+    while (p < end) {
+        const char *line = p;
+        p = skip_blanks(p, end);
+        if (p == end || *p == '\n' || *p == '%') { /* blank line or comment */
+            p = next_line(p, end);
+            continue;
+        }
+        long long r, j;
+        value_t v = 1;
+        if (!(p = get_token(p, end, buf)) || !parse_ll(buf, &r)
+                || !(p = get_token(p, end, buf)) || !parse_ll(buf, &j)
+                || (field != MTX_PATTERN && (!(p = get_token(p, end, buf)) || !parse_value(buf, field, &v)))
+                || r < 1 || r > n || j < 1 || j > n) {
+            c->bad_line = line - base;
+            return;
+        }
+        chunk_push(c, r - 1, j - 1, v);
+        p = next_line(p, end);
+    }
+}
+
+/* Compares the (col, value) pairs used to sort each row */
+struct col_val {
+    long long col;
+    value_t val;
+};
+
+static int cmp_col_val(const void *a, const void *b) {
+    long long x = ((const struct col_val *) a)->col, y = ((const struct col_val *) b)->col;
+    return (x > y) - (x < y);
+}
+
+long long read_mtx_csr(const char *path, int thread_count, struct sparse_matrix_csr *output_mtx_csr) {
+    size_t length;
+    const char *base = map_file(path, &length);
+    const char *end = base + length;
+    madvise((void *) base, length, MADV_SEQUENTIAL); /* every byte is read once, in order within each chunk */
+    if (thread_count < 1) thread_count = 1;
+
+    /* Banner: %%MatrixMarket matrix coordinate <field> <symmetry> */
+    char object[MTX_TOKEN_MAX + 1], format[MTX_TOKEN_MAX + 1], field_s[MTX_TOKEN_MAX + 1], sym_s[MTX_TOKEN_MAX + 1];
+    char buf[MTX_TOKEN_MAX + 1];
+    const char *p = get_token(base, end, buf);
+    if (!p || strcasecmp(buf, "%%MatrixMarket") != 0 || !(p = get_token(p, end, object))
+            || !(p = get_token(p, end, format)) || !(p = get_token(p, end, field_s)) || !get_token(p, end, sym_s)) {
+        fprintf(stderr, "%s: not a Matrix Market file\n", path);
+        exit(EXIT_FAILURE);
+    }
+    if (strcasecmp(object, "matrix") != 0 || strcasecmp(format, "coordinate") != 0) {
+        fprintf(stderr, "%s: only coordinate matrices are supported\n", path);
+        exit(EXIT_FAILURE);
+    }
+    enum mtx_field field;
+    if      (strcasecmp(field_s, "integer") == 0) field = MTX_INTEGER;
+    else if (strcasecmp(field_s, "real") == 0 || strcasecmp(field_s, "double") == 0) field = MTX_REAL;
+    else if (strcasecmp(field_s, "pattern") == 0) field = MTX_PATTERN;
+    else {
+        fprintf(stderr, "%s: unsupported field '%s'\n", path, field_s);
+        exit(EXIT_FAILURE);
+    }
+    enum mtx_symmetry sym;
+    if      (strcasecmp(sym_s, "general") == 0) sym = MTX_GENERAL;
+    else if (strcasecmp(sym_s, "symmetric") == 0) sym = MTX_SYMMETRIC;
+    else if (strcasecmp(sym_s, "skew-symmetric") == 0) sym = MTX_SKEW;
+    else {
+        fprintf(stderr, "%s: unsupported symmetry '%s'\n", path, sym_s);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Size line, after the comments */
+    p = next_line(base, end);
+    long long n = 0, cols = 0, entries = 0;
+    for (;;) {
+        const char *q = skip_blanks(p, end);
+        if (q == end) {
+            fprintf(stderr, "%s: missing size line\n", path);
+            exit(EXIT_FAILURE);
+        }
+        if (*q == '%' || *q == '\n') {
+            p = next_line(q, end);
+            continue;
+        }
+        if (!(q = get_token(q, end, buf)) || !parse_ll(buf, &n) || !(q = get_token(q, end, buf)) || !parse_ll(buf, &cols)
+                || !(q = get_token(q, end, buf)) || !parse_ll(buf, &entries) || n < 1 || entries < 0) {
+            fprintf(stderr, "%s: invalid size line\n", path);
+            exit(EXIT_FAILURE);
+        }
+        p = next_line(q, end);
+        break;
+    }
+    if (n != cols) {
+        fprintf(stderr, "%s: %lldx%lld matrix is not square\n", path, n, cols);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Data section split in equal byte ranges, each moved to the start of a line. Several chunks per thread
+     * keep the threads busy when the line lengths vary along the file. */
+    int nchunks = thread_count == 1 ? 1 : 4 * thread_count;
+    struct mtx_chunk *chunks = xmalloc((size_t) nchunks * sizeof(struct mtx_chunk), "malloc mtx chunks");
+    size_t data_len = (size_t) (end - p);
+    for (int c = 0; c < nchunks; c++) {
+        const char *b = c == 0 ? p : next_line(p + data_len * c / nchunks - 1, end);
+        chunks[c] = (struct mtx_chunk) { .begin = b, .end = end, .bad_line = -1 };
+        if (c > 0) chunks[c-1].end = b > chunks[c-1].begin ? b : chunks[c-1].begin;
+    }
+
+    # pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1)
+    for (int c = 0; c < nchunks; c++)
+        parse_chunk(&chunks[c], base, n, field);
+
+    long long found = 0;
+    for (int c = 0; c < nchunks; c++) {
+        if (chunks[c].bad_line >= 0) {
+            const char *line = base + chunks[c].bad_line;
+            fprintf(stderr, "%s: invalid entry '%.*s'\n", path, (int) (next_line(line, end) - line - 1), line);
+            exit(EXIT_FAILURE);
+        }
+        found += chunks[c].count;
+    }
+    if (found != entries) {
+        fprintf(stderr, "%s: %lld entries found, %lld declared\n", path, found, entries);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Row counts, with the mirrored entries of symmetric matrices (the diagonal of a skew-symmetric matrix is zero) */
+    struct sparse_matrix_csr *csr = output_mtx_csr;
+    csr->rows = n;
+    csr->row_ptr = xmalloc((size_t) (n + 1) * sizeof(long long), "malloc row_ptr");
+    long long *row_ptr = csr->row_ptr;
+
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long long i = 0; i <= n; i++)
+        row_ptr[i] = 0;
+
+    # pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1)
+    for (int c = 0; c < nchunks; c++) {
+        const struct mtx_chunk *ch = &chunks[c];
+        for (long long e = 0; e < ch->count; e++) {
+            long long r = ch->row[e], j = ch->col[e];
+            if (sym == MTX_SKEW && r == j) continue;
+            # pragma omp atomic
+            row_ptr[r + 1]++;
+            if (sym != MTX_GENERAL && r != j) {
+                # pragma omp atomic
+                row_ptr[j + 1]++;
+            }
+        }
+    }
+    for (long long i = 0; i < n; i++)
+        row_ptr[i + 1] += row_ptr[i];
+    long long nnz = row_ptr[n];
+
+    /* Scatter into the rows: FILL[r] is the next free slot of row r */
+    csr->col_index = xmalloc((size_t) nnz * sizeof(long long), "malloc col_index");
+    csr->values = xmalloc((size_t) nnz * sizeof(value_t), "malloc values");
+    long long *fill = xmalloc((size_t) n * sizeof(long long), "malloc fill");
+    memcpy(fill, row_ptr, (size_t) n * sizeof(long long));
+
+    # pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1)
+    for (int c = 0; c < nchunks; c++) {
+        const struct mtx_chunk *ch = &chunks[c];
+        for (long long e = 0; e < ch->count; e++) {
+            long long r = ch->row[e], j = ch->col[e], slot;
+            value_t v = ch->val[e];
+            if (sym == MTX_SKEW && r == j) continue;
+            # pragma omp atomic capture
+            slot = fill[r]++;
+            csr->col_index[slot] = j;
+            csr->values[slot] = v;
+            if (sym != MTX_GENERAL && r != j) {
+                # pragma omp atomic capture
+                slot = fill[j]++;
+                csr->col_index[slot] = r;
+                csr->values[slot] = sym == MTX_SKEW ? -v : v;
+            }
+        }
+    }
+    free(fill);
+    for (int c = 0; c < nchunks; c++) {
+        free(chunks[c].row);
+        free(chunks[c].col);
+        free(chunks[c].val);
+    }
+    free(chunks);
+    munmap((void *) base, length);
+
+    /* Sort the columns of every row (the scatter order depends on the thread schedule) */
+    # pragma omp parallel num_threads(thread_count)
+    {
+        long long cap = 0;
+        struct col_val *tmp = NULL;
+        # pragma omp for schedule(dynamic, 1024)
+        for (long long i = 0; i < n; i++) {
+            long long lo = row_ptr[i], len = row_ptr[i + 1] - lo, k;
+            for (k = 1; k < len && csr->col_index[lo + k - 1] <= csr->col_index[lo + k]; k++);
+            if (k >= len) continue; /* already sorted */
+            if (len > cap) {
+                free(tmp);
+                cap = len;
+                tmp = xmalloc((size_t) cap * sizeof(struct col_val), "malloc row sort");
+            }
+            for (k = 0; k < len; k++)
+                tmp[k] = (struct col_val) { csr->col_index[lo + k], csr->values[lo + k] };
+            qsort(tmp, (size_t) len, sizeof(struct col_val), cmp_col_val);
+            for (k = 0; k < len; k++) {
+                csr->col_index[lo + k] = tmp[k].col;
+                csr->values[lo + k] = tmp[k].val;
+            }
+        }
+        free(tmp);
+    }
+
+    return nnz;
+}
+
+int is_csr_file(const char *path) {
+    char magic[8];
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    int ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, CSR_FILE_MAGIC, sizeof(magic)) == 0;
+    fclose(f);
+    return ok;
+}
+
+static uint64_t align_up(uint64_t x) {
+    return (x + CSR_FILE_ALIGN - 1) / CSR_FILE_ALIGN * CSR_FILE_ALIGN;
+}
+
+/* Writes COUNT bytes of DATA at the current position, after zero padding up to OFFSET */
+static void write_section(FILE *f, const char *path, uint64_t *pos, uint64_t offset, const void *data, size_t count) {
+    static const char zeros[CSR_FILE_ALIGN];
+    if (fwrite(zeros, 1, (size_t) (offset - *pos), f) != (size_t) (offset - *pos)
+            || (count && fwrite(data, 1, count, f) != count)) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    *pos = offset + count;
+}
+
+void write_csr_file(const char *path, const struct sparse_matrix_csr *mtx_csr) {
+    uint64_t rows = (uint64_t) mtx_csr->rows, nnz = (uint64_t) mtx_csr->row_ptr[rows];
+    struct csr_file_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CSR_FILE_MAGIC, sizeof(h.magic));
+    h.rows = rows;
+    h.nnz = nnz;
+    h.index_width = sizeof(long long);
+    h.value_width = sizeof(value_t);
+    h.value_type  = CSR_FILE_VALUE_TYPE;
+    h.row_ptr_offset   = align_up(sizeof(h));
+    h.col_index_offset = align_up(h.row_ptr_offset + (rows + 1) * sizeof(long long));
+    h.values_offset    = align_up(h.col_index_offset + nnz * sizeof(long long));
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t pos = 0;
+    write_section(f, path, &pos, 0, &h, sizeof(h));
+    write_section(f, path, &pos, h.row_ptr_offset, mtx_csr->row_ptr, (rows + 1) * sizeof(long long));
+    write_section(f, path, &pos, h.col_index_offset, mtx_csr->col_index, nnz * sizeof(long long));
+    write_section(f, path, &pos, h.values_offset, mtx_csr->values, nnz * sizeof(value_t));
+    if (fclose(f) != 0) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Whether COUNT elements of SIZE bytes starting at OFFSET lie inside LENGTH bytes (no product or sum can wrap) */
+static int section_fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t length) {
+    return offset <= length && count <= (length - offset) / size;
+}
+
+void csr_map_open(const char *path, int thread_count, struct csr_map *cm) {
+    cm->base = map_file(path, &cm->length);
+    struct csr_file_header h;
+    if (cm->length < sizeof(h)) {
+        fprintf(stderr, "%s: not a binary CSR file\n", path);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&h, cm->base, sizeof(h));
+    if (memcmp(h.magic, CSR_FILE_MAGIC, sizeof(h.magic)) != 0) {
+        fprintf(stderr, "%s: not a binary CSR file\n", path);
+        exit(EXIT_FAILURE);
+    }
+    uint32_t value_type = h.value_type ? h.value_type : VALUE_INT32;
+    if (value_type != CSR_FILE_VALUE_TYPE) {
+        fprintf(stderr, "%s: values are not of the %s type of this build\n", path, VALUE_TYPE_NAME);
+        exit(EXIT_FAILURE);
+    }
+    if (h.index_width != sizeof(long long) || h.value_width != sizeof(value_t)
+            || h.row_ptr_offset % CSR_FILE_ALIGN || h.col_index_offset % CSR_FILE_ALIGN || h.values_offset % CSR_FILE_ALIGN
+            || h.rows >= INT64_MAX || h.nnz > INT64_MAX
+            || !section_fits(h.row_ptr_offset, h.rows + 1, sizeof(long long), cm->length)
+            || !section_fits(h.col_index_offset, h.nnz, sizeof(long long), cm->length)
+            || !section_fits(h.values_offset, h.nnz, sizeof(value_t), cm->length)) {
+        fprintf(stderr, "%s: corrupt binary CSR header\n", path);
+        exit(EXIT_FAILURE);
+    }
+    /* The whole matrix is used by every multiplication: start reading it in now */
+    madvise(cm->base, cm->length, MADV_WILLNEED);
+
+    char *raw = cm->base;
+    cm->csr = init_csr_matrix();
+    cm->csr.rows      = (long long) h.rows;
+    cm->csr.row_ptr   = (long long *) (raw + h.row_ptr_offset);  /* zero copy */
+    cm->csr.col_index = (long long *) (raw + h.col_index_offset);
+    cm->csr.values    = (value_t *) (raw + h.values_offset);
+    if (cm->csr.row_ptr[0] != 0 || (uint64_t) cm->csr.row_ptr[h.rows] != h.nnz) {
+        fprintf(stderr, "%s: row_ptr does not match nnz %llu\n", path, (unsigned long long) h.nnz);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Every kernel trusts row_ptr and col_index: one parallel pass (a fraction of the first SpMV) checks that rows
+     * are monotonic, which keeps them inside [0, nnz], and that every column is a valid row */
+    const long long *row_ptr = cm->csr.row_ptr, *col_index = cm->csr.col_index;
+    long long rows = (long long) h.rows, nnz = (long long) h.nnz;
+    long long bad_rows = 0, bad_cols = 0;
+    if (thread_count < 1) thread_count = 1;
+    # pragma omp parallel num_threads(thread_count)
+    {
+        # pragma omp for schedule(static) reduction(+:bad_rows) nowait
+        for (long long i = 0; i < rows; i++)
+            bad_rows += row_ptr[i+1] < row_ptr[i];
+        # pragma omp for schedule(static) reduction(+:bad_cols)
+        for (long long k = 0; k < nnz; k++)
+            bad_cols += col_index[k] < 0 || col_index[k] >= rows;
+    }
+    if (bad_rows || bad_cols) {
+        fprintf(stderr, "%s: corrupt matrix (%lld decreasing row_ptr entries, %lld columns out of range)\n", path, bad_rows, bad_cols);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void csr_map_close(struct csr_map *cm) {
+    free_csr_caches(&cm->csr);
+    munmap(cm->base, cm->length);
+    cm->csr = init_csr_matrix();
+    cm->base = NULL;
+}
@@ -0,0 +1,146 @@
+#define _GNU_SOURCE /* sched_setaffinity, getcpu */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "csr_numa.h"
+
+/* Pages queried per move_pages call */
+#define NUMA_PAGE_BATCH 4096
+
+int csr_first_touch(struct sparse_matrix_csr *mtx_csr, int thread_count) {
+    long long rows = mtx_csr->rows;
+    const long long *old_row_ptr = mtx_csr->row_ptr;
+    const long long *old_col = mtx_csr->col_index;
+    const value_t *old_val = mtx_csr->values;
+    long long nnz = old_row_ptr[rows];
+
+    long long *row_ptr = malloc((rows + 1) * sizeof(long long));
+    long long *col_index = malloc((nnz > 0 ? nnz : 1) * sizeof(long long));
+    value_t *values = malloc((nnz > 0 ? nnz : 1) * sizeof(value_t));
+    if (!row_ptr || !col_index || !values) {
+        free(row_ptr);
+        free(col_index);
+        free(values);
+        return 0;
+    }
+
+    /* Same loop and schedule as the multiplication: the thread copying row i is the one multiplying it */
+    row_ptr[0] = 0;
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long long i = 0; i < rows; i++) {
+        row_ptr[i+1] = old_row_ptr[i+1];
+        for (long long j = old_row_ptr[i]; j < old_row_ptr[i+1]; j++) {
+            col_index[j] = old_col[j];
+            values[j] = old_val[j];
+        }
+    }
+
+    free(mtx_csr->row_ptr);
+    free(mtx_csr->col_index);
+    free(mtx_csr->values);
+    mtx_csr->row_ptr = row_ptr;
+    mtx_csr->col_index = col_index;
+    mtx_csr->values = values;
+    return 1;
+}
+
+int numa_pin_threads(int thread_count) {
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        perror("sched_getaffinity");
+        return 0;
+    }
+    int ncpus = CPU_COUNT(&allowed);
+    int *cpus = malloc((ncpus > 0 ? ncpus : 1) * sizeof(int));
+    if (!cpus) {
+        perror("malloc cpus");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0, k = 0; c < CPU_SETSIZE && k < ncpus; c++) {
+        if (CPU_ISSET(c, &allowed)) cpus[k++] = c;
+    }
+
+    int pinned = 0;
+    # pragma omp parallel num_threads(thread_count) reduction(+:pinned)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int nthreads = omp_get_num_threads();
+        #else
+        int tid = 0;
+        int nthreads = 1;
+        #endif
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[(long long) tid * ncpus / nthreads], &set);
+        if (sched_setaffinity(0, sizeof(set), &set) == 0) pinned++; /* 0: the calling thread */
+    }
+
+    free(cpus);
+    return pinned;
+}
+
+int numa_thread_nodes(int thread_count, int *node) {
+    int nnodes = 0;
+    # pragma omp parallel num_threads(thread_count) reduction(max:nnodes)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        #else
+        int tid = 0;
+        #endif
+        unsigned int cpu, n;
+        if (getcpu(&cpu, &n) == 0 && n < NUMA_MAX_NODES) {
+            node[tid] = (int) n;
+            nnodes = (int) n + 1;
+        } else {
+            node[tid] = -1;
+        }
+    }
+    return nnodes;
+}
+
+long long numa_page_nodes(const void *p, size_t bytes, long long *per_node) {
+    #ifdef SYS_move_pages
+    long page = sysconf(_SC_PAGESIZE);
+    if (bytes == 0) return 0;
+    uintptr_t first = (uintptr_t) p / page * page;
+    size_t npages = ((uintptr_t) p + bytes - first + page - 1) / page;
+    void *pages[NUMA_PAGE_BATCH];
+    int status[NUMA_PAGE_BATCH];
+    long long found = 0;
+
+    for (size_t b = 0; b < npages; b += NUMA_PAGE_BATCH) {
+        size_t count = npages - b < NUMA_PAGE_BATCH ? npages - b : NUMA_PAGE_BATCH;
+        for (size_t k = 0; k < count; k++)
+            pages[k] = (void *) (first + (b + k) * page);
+        /* With no target nodes, move_pages only reports the node of every page in status */
+        if (syscall(SYS_move_pages, 0, (unsigned long) count, pages, NULL, status, 0) != 0)
+            return -1;
+        for (size_t k = 0; k < count; k++) {
+            if (status[k] >= 0 && status[k] < NUMA_MAX_NODES) {
+                per_node[status[k]]++;
+                found++;
+            }
+        }
+    }
+    return found;
+    #else
+    (void) p; (void) bytes; (void) per_node;
+    return -1;
+    #endif
+}
+
+double csr_spmv_bytes(const struct sparse_matrix_csr *A, long long lo, long long hi) {
+    double nnz = (double) (A->row_ptr[hi] - A->row_ptr[lo]);
+    return nnz * (sizeof(value_t) + sizeof(long long) + sizeof(vec_t)) + (double) (hi - lo + 1) * sizeof(long long)
+           + (double) (hi - lo) * sizeof(vec_t);
+}
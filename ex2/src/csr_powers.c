@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h> /* sysconf */
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "csr_powers.h"
+
+static void *xmalloc(size_t size, const char *what) {
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* Cache bytes available to each of THREAD_COUNT threads */
+static long long powers_cache_bytes(int thread_count) {
+    if (CSR_POWERS_CACHE_BYTES > 0) return CSR_POWERS_CACHE_BYTES;
+    #ifdef _SC_LEVEL3_CACHE_SIZE
+    long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l3 > 0) return l3 / thread_count;
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0) return l2;
+    #endif
+    return 1 << 20;
+}
+
+static void free_blocks(struct csr_powers_plan *plan) {
+    if (!plan->blocks) return;
+    for (long long b = 0; b < plan->nblocks; b++) {
+        free(plan->blocks[b].ids);
+        free(plan->blocks[b].count);
+        free(plan->blocks[b].row_ptr);
+        free(plan->blocks[b].col);
+        free(plan->blocks[b].values);
+    }
+    free(plan->blocks);
+    plan->blocks = NULL;
+}
+
+void free_csr_powers_plan(struct csr_powers_plan *plan) {
+    if (!plan) return;
+    free_blocks(plan);
+    free(plan);
+}
+
+/* Per-thread scratch of the block builder, indexed by matrix row. stamp[g] == b marks the rows already in block b
+ * (stamping with the block number avoids clearing the arrays between blocks); lidx[g] is then their local index. */
+struct powers_scratch {
+    long long *stamp;
+    long long *lidx;
+};
+
+/* Builds block B owning rows [lo, hi) for rounds of S steps. Returns the elements multiplied per round,
+ * or -1 as soon as they exceed CAP (the block is then left empty). */
+static long long build_block(const struct sparse_matrix_csr *A, long long b, long long lo, long long hi, int s,
+                             long long cap, struct powers_scratch *sc, struct csr_powers_block *blk) {
+    const long long *row_ptr = A->row_ptr;
+    long long owned = hi - lo;
+    long long size = owned > 16 ? 2 * owned : 32;
+    long long *ids = xmalloc(size * sizeof(long long), "malloc powers ids");
+    long long *count = xmalloc((s + 1) * sizeof(long long), "malloc powers count");
+    long long work = 0;
+
+    /* Owned rows first, at level s */
+    for (long long g = lo; g < hi; g++) {
+        sc->stamp[g] = b;
+        sc->lidx[g] = g - lo;
+        ids[g - lo] = g;
+    }
+    long long n = owned;
+    count[s] = owned;
+
+    /* Rows of level k need the columns of their row at level k-1: breadth-first, one level at a time */
+    long long begin = 0;
+    for (int k = s; k >= 1; k--) {
+        long long end = n;
+        for (long long l = begin; l < end; l++) {
+            long long g = ids[l];
+            work += (row_ptr[g+1] - row_ptr[g]) * k; /* computed at steps 1 to k of a round */
+            if (work > cap) {
+                free(ids);
+                free(count);
+                return -1;
+            }
+            for (long long j = row_ptr[g]; j < row_ptr[g+1]; j++) {
+                long long c = A->col_index[j];
+                if (sc->stamp[c] == b) continue; /* already at a level >= k-1 */
+                if (n == size) {
+                    size *= 2;
+                    ids = realloc(ids, size * sizeof(long long));
+                    if (!ids) {
+                        perror("realloc powers ids");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                sc->stamp[c] = b; /* level k-1 */
+                sc->lidx[c] = n;
+                ids[n++] = c;
+            }
+        }
+        count[k-1] = n;
+        begin = end;
+    }
+
+    /* Local CSR copy of the computed rows (level >= 1) */
+    long long nrows = count[1];
+    long long nnz = 0;
+    for (long long l = 0; l < nrows; l++) {
+        nnz += row_ptr[ids[l]+1] - row_ptr[ids[l]];
+    }
+    blk->row_ptr = xmalloc((nrows + 1) * sizeof(long long), "malloc powers row_ptr");
+    blk->col     = xmalloc(nnz * sizeof(int), "malloc powers col");
+    blk->values  = xmalloc(nnz * sizeof(value_t), "malloc powers values");
+    blk->row_ptr[0] = 0;
+    long long idx = 0;
+    for (long long l = 0; l < nrows; l++) {
+        long long g = ids[l];
+        for (long long j = row_ptr[g]; j < row_ptr[g+1]; j++) {
+            blk->col[idx]    = (int) sc->lidx[A->col_index[j]];
+            blk->values[idx] = A->values[j];
+            idx++;
+        }
+        blk->row_ptr[l+1] = idx;
+    }
+
+    blk->row_lo = lo;
+    blk->nlocal = n;
+    blk->ids = ids;
+    blk->count = count;
+    return work;
+}
+
+/* Tries to build the blocks of PLAN for S steps per round. Returns 0 (blocks freed) if the redundant work is too large. */
+static int build_blocks(struct sparse_matrix_csr *A, struct csr_powers_plan *plan, int s, const long long *block_start, int thread_count) {
+    long long rows = A->rows;
+    long long nblocks = plan->nblocks;
+    int ok = 1;
+    long long work = 0, max_local = 0;
+
+    plan->blocks = xmalloc(nblocks * sizeof(struct csr_powers_block), "malloc powers blocks");
+    for (long long b = 0; b < nblocks; b++) {
+        plan->blocks[b].ids = NULL;
+        plan->blocks[b].count = NULL;
+        plan->blocks[b].row_ptr = NULL;
+        plan->blocks[b].col = NULL;
+        plan->blocks[b].values = NULL;
+    }
+
+    # pragma omp parallel num_threads(thread_count) reduction(&&:ok) reduction(+:work) reduction(max:max_local)
+    {
+        struct powers_scratch sc;
+        sc.stamp = xmalloc(rows * sizeof(long long), "malloc powers stamp");
+        sc.lidx  = xmalloc(rows * sizeof(long long), "malloc powers lidx");
+        for (long long g = 0; g < rows; g++) {
+            sc.stamp[g] = -1;
+        }
+
+        # pragma omp for schedule(dynamic, 1)
+        for (long long b = 0; b < nblocks; b++) {
+            if (!ok) continue; /* another block of this thread already failed */
+            long long lo = block_start[b], hi = block_start[b+1];
+            long long block_nnz = A->row_ptr[hi] - A->row_ptr[lo];
+            long long cap = (long long) (CSR_POWERS_MAX_REDUNDANCY * s * (block_nnz + 1));
+            long long w = build_block(A, b, lo, hi, s, cap, &sc, &plan->blocks[b]);
+            if (w < 0) {
+                ok = 0;
+            } else {
+                work += w;
+                if (plan->blocks[b].nlocal > max_local) max_local = plan->blocks[b].nlocal;
+            }
+        }
+
+        free(sc.stamp);
+        free(sc.lidx);
+    }
+
+    if (!ok || work > CSR_POWERS_MAX_REDUNDANCY * s * A->row_ptr[rows]) {
+        free_blocks(plan);
+        return 0;
+    }
+    plan->s = s;
+    plan->work = work;
+    plan->max_local = max_local;
+    return 1;
+}
+
+struct csr_powers_plan *csr_powers_plan_create(struct sparse_matrix_csr *mtx_csr, int s, int thread_count) {
+    if (s < 1) s = 1;
+    if (thread_count < 1) thread_count = 1;
+
+    long long rows = mtx_csr->rows;
+    const long long *row_ptr = mtx_csr->row_ptr;
+    long long nnz = row_ptr[rows];
+
+    struct csr_powers_plan *plan = xmalloc(sizeof(struct csr_powers_plan), "malloc powers plan");
+    plan->nparts = thread_count;
+    plan->s = 1;
+    plan->blocks = NULL;
+    plan->max_local = 0;
+    plan->work = nnz;
+
+    /* Blocks of contiguous rows with about target non-zeros each (8 bytes per non-zero in the local copy, half the
+     * cache left for the ghost rows and the vectors), and at least one block per thread */
+    long long target = powers_cache_bytes(thread_count) / 16;
+    long long nblocks = (nnz + target - 1) / target;
+    if (nblocks < thread_count) nblocks = thread_count;
+    if (nblocks > rows) nblocks = rows > 0 ? rows : 1;
+    long long *block_start = xmalloc((nblocks + 1) * sizeof(long long), "malloc powers block_start");
+    block_start[0] = 0;
+    long long i = 0;
+    for (long long b = 1; b < nblocks; b++) {
+        long long goal = nnz / nblocks * b + nnz % nblocks * b / nblocks;
+        while (i < rows && row_ptr[i] < goal) i++;
+        if (i < block_start[b-1] + 1) i = block_start[b-1] + 1; /* no empty block */
+        if (i > rows - (nblocks - b)) i = rows - (nblocks - b);
+        block_start[b] = i;
+    }
+    block_start[nblocks] = rows;
+    plan->nblocks = nblocks;
+
+    /* Largest s whose ghost rows stay affordable */
+    for (int t = s; t >= 2; t--) {
+        if (build_blocks(mtx_csr, plan, t, block_start, thread_count)) break;
+    }
+
+    free(block_start);
+    return plan;
+}
@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "csr_reorder.h"
+
+/* Number of times the search for a pseudo-peripheral row restarts from the farthest row found */
+#define RCM_PERIPHERAL_ITERS 5
+
+static void *xmalloc(size_t size, const char *what) {
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* Pattern of A + A^T as two adjacency lists: the columns of row i of A, then the rows of column i (from the transpose).
+ * A neighbor may appear in both lists, which only costs a second visited check. For a symmetric pattern the second
+ * list is empty (t_ptr all zeros). */
+struct rcm_graph {
+    long long n;
+    const long long *a_ptr;
+    const long long *a_idx;
+    long long *t_ptr;
+    long long *t_idx;
+    long long *degree;
+};
+
+/* Sort key pair: a row and its degree, or a column and its value */
+struct key_pair {
+    long long key;
+    long long item;
+};
+
+static int cmp_key(const void *a, const void *b) {
+    const struct key_pair *pa = a, *pb = b;
+    if (pa->key != pb->key) return pa->key < pb->key ? -1 : 1;
+    return (pa->item > pb->item) - (pa->item < pb->item);
+}
+
+static struct rcm_graph build_graph(const struct sparse_matrix_csr *A, int symmetric) {
+    struct rcm_graph g;
+    long long n = A->rows;
+    long long nnz = A->row_ptr[n];
+    g.n = n;
+    g.a_ptr = A->row_ptr;
+    g.a_idx = A->col_index;
+    g.t_ptr = xmalloc((n + 1) * sizeof(long long), "malloc rcm t_ptr");
+    g.t_idx = xmalloc((symmetric ? 0 : nnz) * sizeof(long long), "malloc rcm t_idx");
+    g.degree = xmalloc(n * sizeof(long long), "malloc rcm degree");
+
+    for (long long i = 0; i <= n; i++) {
+        g.t_ptr[i] = 0;
+    }
+    if (!symmetric) {
+        /* Transposed pattern: count the entries of every column, then place the rows in increasing order */
+        for (long long j = 0; j < nnz; j++) {
+            g.t_ptr[A->col_index[j] + 1]++;
+        }
+        for (long long i = 0; i < n; i++) {
+            g.t_ptr[i+1] += g.t_ptr[i];
+        }
+        long long *fill = xmalloc(n * sizeof(long long), "malloc rcm fill");
+        for (long long i = 0; i < n; i++) {
+            fill[i] = g.t_ptr[i];
+        }
+        for (long long i = 0; i < n; i++) {
+            for (long long j = A->row_ptr[i]; j < A->row_ptr[i+1]; j++) {
+                g.t_idx[fill[A->col_index[j]]++] = i;
+            }
+        }
+        free(fill);
+    }
+
+    for (long long i = 0; i < n; i++) {
+        g.degree[i] = (g.a_ptr[i+1] - g.a_ptr[i]) + (g.t_ptr[i+1] - g.t_ptr[i]);
+    }
+    return g;
+}
+
+static void free_graph(struct rcm_graph *g) {
+    free(g->t_ptr);
+    free(g->t_idx);
+    free(g->degree);
+}
+
+/* Breadth-first search from ROOT over the rows not in DONE. SEEN[v] == STAMP marks the rows reached by this search,
+ * so that SEEN needs no clearing between searches. Returns the number of levels, and in *FAR the row of least degree
+ * of the last level. */
+static long long bfs_depth(const struct rcm_graph *g, long long root, const char *done, long long *seen, long long stamp,
+                           long long *queue, long long *far) {
+    long long head = 0, tail = 0, depth = 0;
+    queue[tail++] = root;
+    seen[root] = stamp;
+    while (head < tail) {
+        long long level_end = tail;
+        *far = queue[head];
+        for (long long q = head; q < level_end; q++) {
+            long long v = queue[q];
+            if (g->degree[v] < g->degree[*far]) *far = v;
+            for (int side = 0; side < 2; side++) {
+                const long long *ptr = side ? g->t_ptr : g->a_ptr;
+                const long long *idx = side ? g->t_idx : g->a_idx;
+                for (long long j = ptr[v]; j < ptr[v+1]; j++) {
+                    long long w = idx[j];
+                    if (done[w] || seen[w] == stamp) continue;
+                    seen[w] = stamp;
+                    queue[tail++] = w;
+                }
+            }
+        }
+        head = level_end;
+        depth++;
+    }
+    return depth;
+}
+
+long long *csr_rcm_permutation(struct sparse_matrix_csr *mtx_csr, int symmetric) {
+    long long n = mtx_csr->rows;
+    struct rcm_graph g = build_graph(mtx_csr, symmetric);
+    long long *order = xmalloc(n * sizeof(long long), "malloc rcm order");
+    long long *queue = xmalloc(n * sizeof(long long), "malloc rcm queue");
+    long long *seen  = xmalloc(n * sizeof(long long), "malloc rcm seen");
+    struct key_pair *pairs = xmalloc(n * sizeof(struct key_pair), "malloc rcm pairs");
+    char *done = calloc(n > 0 ? n : 1, sizeof(char));
+    if (!done) {
+        perror("calloc rcm done");
+        exit(EXIT_FAILURE);
+    }
+    for (long long i = 0; i < n; i++) {
+        seen[i] = -1;
+    }
+
+    long long stamp = 0, count = 0;
+    for (long long seed = 0; seed < n; seed++) {
+        if (done[seed]) continue;
+
+        /* Pseudo-peripheral root of the component of SEED: restart from the far end while the depth grows */
+        long long root = seed, far;
+        long long depth = bfs_depth(&g, root, done, seen, stamp++, queue, &far);
+        for (int it = 0; it < RCM_PERIPHERAL_ITERS && far != root; it++) {
+            long long far_next;
+            long long d = bfs_depth(&g, far, done, seen, stamp++, queue, &far_next);
+            if (d <= depth) break;
+            root = far;
+            depth = d;
+            far = far_next;
+        }
+
+        /* Cuthill-McKee: breadth-first order, the new neighbors of every row by increasing degree */
+        long long head = count;
+        order[count++] = root;
+        done[root] = 1;
+        while (head < count) {
+            long long v = order[head++];
+            long long added = 0;
+            for (int side = 0; side < 2; side++) {
+                const long long *ptr = side ? g.t_ptr : g.a_ptr;
+                const long long *idx = side ? g.t_idx : g.a_idx;
+                for (long long j = ptr[v]; j < ptr[v+1]; j++) {
+                    long long w = idx[j];
+                    if (done[w]) continue;
+                    done[w] = 1;
+                    pairs[added].key = g.degree[w];
+                    pairs[added].item = w;
+                    added++;
+                }
+            }
+            qsort(pairs, added, sizeof(struct key_pair), cmp_key);
+            for (long long a = 0; a < added; a++) {
+                order[count++] = pairs[a].item;
+            }
+        }
+    }
+
+    /* Reverse */
+    long long *perm = xmalloc(n * sizeof(long long), "malloc rcm perm");
+    for (long long i = 0; i < n; i++) {
+        perm[i] = order[n - 1 - i];
+    }
+
+    free(order);
+    free(queue);
+    free(seen);
+    free(pairs);
+    free(done);
+    free_graph(&g);
+    return perm;
+}
+
+struct csr_reordered csr_permute(struct sparse_matrix_csr *mtx_csr, long long *perm, int thread_count) {
+    struct csr_reordered R;
+    long long n = mtx_csr->rows;
+    long long nnz = mtx_csr->row_ptr[n];
+    if (thread_count < 1) thread_count = 1;
+
+    struct sparse_matrix_csr *B = xmalloc(sizeof(struct sparse_matrix_csr), "malloc permuted csr");
+    *B = init_csr_matrix();
+    B->rows = n;
+    B->row_ptr   = xmalloc((n + 1) * sizeof(long long), "malloc permuted row_ptr");
+    B->col_index = xmalloc(nnz * sizeof(long long), "malloc permuted col_index");
+    B->values    = xmalloc(nnz * sizeof(value_t), "malloc permuted values");
+    R.mtx = B;
+    R.perm = perm;
+    R.iperm = xmalloc(n * sizeof(long long), "malloc iperm");
+
+    /* Longest row, for the per-thread sort buffers */
+    long long max_len = 0;
+    for (long long i = 0; i < n; i++) {
+        if (mtx_csr->row_ptr[i+1] - mtx_csr->row_ptr[i] > max_len) max_len = mtx_csr->row_ptr[i+1] - mtx_csr->row_ptr[i];
+    }
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        struct key_pair *pairs = xmalloc(max_len * sizeof(struct key_pair), "malloc permute pairs");
+
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < n; i++) {
+            R.iperm[perm[i]] = i;
+        }
+
+        /* Row lengths, then offsets */
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < n; i++) {
+            B->row_ptr[i+1] = mtx_csr->row_ptr[perm[i]+1] - mtx_csr->row_ptr[perm[i]];
+        } /* implicit barrier */
+
+        # pragma omp single
+        {
+            B->row_ptr[0] = 0;
+            for (long long i = 0; i < n; i++) {
+                B->row_ptr[i+1] += B->row_ptr[i];
+            }
+        } /* implicit barrier */
+
+        /* Renumbered columns, sorted with the position of their values */
+        # pragma omp for schedule(dynamic, 256)
+        for (long long i = 0; i < n; i++) {
+            long long src = mtx_csr->row_ptr[perm[i]];
+            long long dst = B->row_ptr[i];
+            long long len = B->row_ptr[i+1] - dst;
+            for (long long k = 0; k < len; k++) {
+                pairs[k].key  = R.iperm[mtx_csr->col_index[src + k]];
+                pairs[k].item = src + k;
+            }
+            qsort(pairs, len, sizeof(struct key_pair), cmp_key);
+            for (long long k = 0; k < len; k++) {
+                B->col_index[dst + k] = pairs[k].key;
+                B->values[dst + k]    = mtx_csr->values[pairs[k].item];
+            }
+        }
+
+        free(pairs);
+    }
+
+    return R;
+}
+
+void free_csr_reordered(struct csr_reordered *R) {
+    free_csr_matrix(R->mtx); /* frees the struct as well */
+    free(R->perm);
+    free(R->iperm);
+    R->mtx = NULL;
+    R->perm = NULL;
+    R->iperm = NULL;
+}
+
+long long csr_bandwidth(const struct sparse_matrix_csr *mtx_csr) {
+    long long bw = 0;
+    for (long long i = 0; i < mtx_csr->rows; i++) {
+        for (long long j = mtx_csr->row_ptr[i]; j < mtx_csr->row_ptr[i+1]; j++) {
+            long long d = mtx_csr->col_index[j] > i ? mtx_csr->col_index[j] - i : i - mtx_csr->col_index[j];
+            if (d > bw) bw = d;
+        }
+    }
+    return bw;
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "csr_spmv_plan.h"
+
+static void *xmalloc(size_t size, const char *what) {
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+struct csr_spmv_plan *csr_spmv_plan_create(struct sparse_matrix_csr *mtx_csr, int thread_count) {
+    if (thread_count < 1) thread_count = 1;
+    long long rows = mtx_csr->rows;
+    struct csr_spmv_plan *plan = xmalloc(sizeof(*plan), "malloc spmv plan");
+    plan->A = mtx_csr;
+    plan->nparts = thread_count;
+
+    /* Copied: the partition cached in the matrix is replaced if it is later asked for another thread count */
+    const struct csr_partition *part = csr_row_partition(mtx_csr, thread_count);
+    plan->row_start = xmalloc((thread_count + 1) * sizeof(long long), "malloc spmv plan row_start");
+    for (int p = 0; p <= thread_count; p++)
+        plan->row_start[p] = part->row_start[p];
+
+    plan->x_tmp[0] = xmalloc(2 * rows * sizeof(vec_t), "malloc spmv plan x_tmp");
+    plan->x_tmp[1] = &plan->x_tmp[0][rows];
+
+    /* First touch with the schedule of the multiplications: every page of a part is mapped by the thread writing it */
+    const long long *row_start = plan->row_start;
+    vec_t *x0 = plan->x_tmp[0], *x1 = plan->x_tmp[1];
+    # pragma omp parallel for num_threads(thread_count) schedule(static, 1)
+    for (int p = 0; p < thread_count; p++) {
+        for (long long i = row_start[p]; i < row_start[p+1]; i++) {
+            x0[i] = 0;
+            x1[i] = 0;
+        }
+    }
+
+    return plan;
+}
+
+void free_csr_spmv_plan(struct csr_spmv_plan *plan) {
+    if (!plan) return;
+    free(plan->row_start);
+    free(plan->x_tmp[0]);
+    free(plan);
+}
+
+void csr_spmv_execute_team(struct csr_spmv_plan *plan, const vec_t *x, vec_t *res, int iters) {
+    const struct sparse_matrix_csr *A = plan->A;
+    const long long *row_start = plan->row_start;
+    const long long *row_ptr = A->row_ptr;
+    const long long *col_index = A->col_index;
+    const value_t *values = A->values;
+    int nparts = plan->nparts;
+
+    if (iters < 1) {
+        /* Copy input vector to output vector, each thread its own rows. */
+        # pragma omp for schedule(static, 1)
+        for (int p = 0; p < nparts; p++) {
+            for (long long i = row_start[p]; i < row_start[p+1]; i++) {
+                res[i] = x[i];
+            }
+        }
+        return;
+    }
+
+    /* Step r reads x (r = 0) or a ping-pong vector, and writes a ping-pong vector or res (last step) */
+    const vec_t *x_read = x;
+    for (int r = 0; r < iters; r++) {
+        vec_t *x_write = r == iters - 1 ? res : plan->x_tmp[r % 2];
+
+        # pragma omp for schedule(static, 1)
+        for (int p = 0; p < nparts; p++) {
+            for (long long i = row_start[p]; i < row_start[p+1]; i++) {
+                vec_t sum = 0;
+                for (long long j = row_ptr[i]; j < row_ptr[i+1]; j++) {
+                    sum += values[j] * x_read[col_index[j]];
+                }
+                x_write[i] = sum;
+            }
+        } /* implicit barrier: the step is complete before the next one reads it */
+
+        x_read = x_write;
+    }
+}
+
+void csr_spmv_execute(struct csr_spmv_plan *plan, const vec_t *x, vec_t *res, int iters) {
+    # pragma omp parallel num_threads(plan->nparts)
+    csr_spmv_execute_team(plan, x, res, iters);
+}
@@ -3,8 +3,8 @@
 
 #include "gen_int_array.h"
 
-int *gen_int_array(long long size, int max_val){
-    int *arr = malloc((size_t)(size) * sizeof(int));
+vec_t *gen_int_array(long long size, int max_val){
+    vec_t *arr = malloc((size_t)(size) * sizeof(vec_t));
     if (!arr) {
         perror("malloc arr");
         exit(EXIT_FAILURE);
@@ -12,7 +12,7 @@ int *gen_int_array(long long size, int max_val){
 
     if (max_val < 1) max_val = RAND_MAX;
     for (long long i = 0; i < size; i++){
-        arr[i] = rand() % max_val + 1; /* in range [1, max_val] */
+        arr[i] = (vec_t) (rand() % max_val + 1); /* in range [1, max_val] */
     }
 
     return arr;
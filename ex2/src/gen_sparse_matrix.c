@@ -1,21 +1,38 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
 #include "gen_sparse_matrix.h"
 
-int **gen_sparse_matrix(long long rows, long long cols, float sparsity, int max_val, int thread_count, struct xorshift32_state *state, long long *nnz){
+#if !VALUE_IS_INT
+/* Scales the LEN values of a row to sum 1. With integer values in [1, max_val], every multiplication grows the vector
+ * by about nnz * max_val / 2 per row, which overflows float after a few tens of steps (and 0 * inf in the padding
+ * of the dense and SELL kernels then gives NaN). A row-stochastic matrix averages the vector instead. */
+static void normalize_row(value_t *v, long long len) {
+    double sum = 0;
+    for (long long k = 0; k < len; k++)
+        sum += v[k];
+    if (sum > 0) {
+        for (long long k = 0; k < len; k++)
+            v[k] = (value_t) (v[k] / sum);
+    }
+}
+#endif
+
+value_t **gen_sparse_matrix(long long rows, long long cols, float sparsity, int max_val, int thread_count, struct xorshift32_state *state, long long *nnz){
     /* Allocation for all the matrix elements, initialized to 0 */
-    int *data = calloc((size_t)(rows * cols), sizeof(int));
+    value_t *data = calloc((size_t)(rows * cols), sizeof(value_t));
     if (!data) {
         perror("malloc data");
         exit(EXIT_FAILURE);
     }
 
-    /* Allocation of ROWS pointers to int pointers (row arrays) */
-    int **mtx = malloc((size_t)(rows) * sizeof(int*));
+    /* Allocation of ROWS pointers to value_t pointers (row arrays) */
+    value_t **mtx = malloc((size_t)(rows) * sizeof(value_t*));
     if (!mtx) {
         perror("malloc mtx");
         exit(EXIT_FAILURE);
@@ -48,14 +65,150 @@ int **gen_sparse_matrix(long long rows, long long cols, float sparsity, int max_
         for (long long i = 0; i < rows; i++){
             for (long long j = 0; j < cols; j++){
                 if ((xorshift32(&my_state) % 10000) >= (size_t)(sparsity*10000)) /* Apply sparsity */ {
-                    mtx[i][j] = xorshift32(&my_state) % max_val + 1; /* in range [1, max_val] */
+                    mtx[i][j] = (value_t) (xorshift32(&my_state) % max_val + 1); /* integer in range [1, max_val] */
                     nnz_global++;
                 }
             }
+            #if !VALUE_IS_INT
+            normalize_row(mtx[i], cols);
+            #endif
         }
     }
 
     *nnz = nnz_global;
     
     return mtx;
-}
\ No newline at end of file
+}
+
+/* Below this probability of a non-zero, rows are generated by skipping over the zeros (geometric gaps)
+ * instead of testing every column */
+#define GEN_CSR_SKIP_MAX_DENSITY 0.25
+
+/* Non-zero seed of the random stream STREAM of row I: a SplitMix64 finalizer over (seed, row, stream) */
+static inline uint32_t row_seed(uint32_t seed, long long i, uint32_t stream) {
+    uint64_t x = ((uint64_t) seed << 32 | stream) + (uint64_t) i * 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    uint32_t s = (uint32_t) (x >> 32);
+    return s ? s : 1;
+}
+
+/* Walks the non-zero columns of row I in increasing order and returns how many there are.
+ * If COL_OUT is not NULL, the columns are also written to it. Replaying a row gives the same columns. */
+static long long row_pattern(uint32_t seed, long long i, long long cols, uint32_t threshold, double log_zero, long long *col_out) {
+    struct xorshift32_state st = { row_seed(seed, i, 0) };
+    long long count = 0;
+
+    if (log_zero == 0.0) {
+        /* Dense rows: same per-element test as gen_sparse_matrix */
+        for (long long j = 0; j < cols; j++) {
+            if ((xorshift32(&st) % 10000) >= threshold) {
+                if (col_out) col_out[count] = j;
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /* Sparse rows: the gap before the next non-zero is geometric, P(gap = g) = p0^g * (1 - p0) */
+    long long j = -1;
+    for (;;) {
+        double u = (xorshift32(&st) + 0.5) * (1.0 / 4294967296.0); /* uniform in (0, 1) */
+        double gap = floor(log(u) / log_zero);
+        if (gap >= (double) (cols - 1 - j)) break;
+        j += 1 + (long long) gap;
+        if (col_out) col_out[count] = j;
+        count++;
+    }
+    return count;
+}
+
+long long gen_sparse_matrix_csr(long long rows, long long cols, float sparsity, int max_val, int thread_count, struct xorshift32_state *state, struct sparse_matrix_csr *output_mtx_csr){
+    struct sparse_matrix_csr *csr = output_mtx_csr;
+    csr->rows = rows;
+    csr->row_ptr = malloc((rows + 1) * sizeof(long long));
+    if (!csr->row_ptr) {
+        perror("malloc row_ptr");
+        exit(EXIT_FAILURE);
+    }
+    csr->row_ptr[0] = 0;
+
+    if (max_val < 1) max_val = RAND_MAX;
+    if (thread_count < 1) thread_count = 1;
+    uint32_t seed = state->a;
+    uint32_t threshold = (uint32_t)(sparsity*10000); /* element is non-zero if xorshift32 % 10000 >= threshold */
+    double p_nonzero = (10000 - threshold) / 10000.0;
+    double log_zero = p_nonzero <= GEN_CSR_SKIP_MAX_DENSITY ? log1p(-p_nonzero) : 0.0;
+
+    long long *thread_nnz = calloc(thread_count + 1, sizeof(long long));
+    if (!thread_nnz) {
+        perror("calloc thread_nnz");
+        exit(EXIT_FAILURE);
+    }
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        int nthreads = omp_get_num_threads();
+        #else
+        int tid = 0;
+        int nthreads = 1;
+        #endif
+
+        /* Contiguous rows per thread, so that the prefix sum can be done per thread block */
+        long long base_chunk = rows / nthreads;
+        int rem = rows % nthreads;
+        long long my_start = tid * base_chunk + (tid < rem ? tid : rem);
+        long long my_end   = my_start + base_chunk + (tid < rem ? 1 : 0);
+
+        /* Pass 1: non-zeros per row, and a running sum within the thread's block */
+        long long my_sum = 0;
+        for (long long i = my_start; i < my_end; i++) {
+            my_sum += row_pattern(seed, i, cols, threshold, log_zero, NULL);
+            csr->row_ptr[i+1] = my_sum;
+        }
+        thread_nnz[tid + 1] = my_sum;
+        # pragma omp barrier
+
+        /* Exclusive scan of the per-thread sums (one value per thread), then allocation of the CSR arrays */
+        # pragma omp single
+        {
+            for (int t = 1; t <= nthreads; t++)
+                thread_nnz[t] += thread_nnz[t-1];
+            long long nnz = thread_nnz[nthreads];
+            csr->col_index = malloc(nnz * sizeof(long long));
+            csr->values    = malloc(nnz * sizeof(value_t));
+            if ((nnz && !csr->col_index) || (nnz && !csr->values)) {
+                perror("malloc csr arrays");
+                exit(EXIT_FAILURE);
+            }
+        } /* implicit barrier */
+
+        /* Offset the block to its global position */
+        long long my_offset = thread_nnz[tid];
+        for (long long i = my_start; i < my_end; i++)
+            csr->row_ptr[i+1] += my_offset;
+        # pragma omp barrier
+
+        /* Pass 2: replay every row into its slot, values from a second stream of the row.
+         * The static schedule of matvecs_csr_parallel: the thread that will multiply a row first touches its pages. */
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < rows; i++) {
+            long long start = csr->row_ptr[i];
+            long long count = row_pattern(seed, i, cols, threshold, log_zero, &csr->col_index[start]);
+            struct xorshift32_state vst = { row_seed(seed, i, 1) };
+            for (long long k = start; k < start + count; k++)
+                csr->values[k] = (value_t) (xorshift32(&vst) % max_val + 1); /* integer in range [1, max_val] */
+            #if !VALUE_IS_INT
+            normalize_row(&csr->values[start], count);
+            #endif
+        }
+    }
+
+    long long nnz = csr->row_ptr[rows];
+    free(thread_nnz);
+
+    return nnz;
+}
@@ -4,10 +4,18 @@
 #include <omp.h>
 #endif
 
+#include "value_type.h"
+
+/* The vector kernels are int32 only */
+#if (defined(__x86_64__) || defined(__i386__)) && VALUE_IS_INT
+#define MATVECS_X86
+#include <immintrin.h>
+#endif
+
 #include "matvecs.h"
 // #include "util_matvec.h"
 
-void matvecs(int **A, int *x, int *res, long long size, int iters){
+void matvecs(value_t **A, vec_t *x, vec_t *res, long long size, int iters){
     long long i, j;
     int r;
 
@@ -22,8 +30,8 @@ void matvecs(int **A, int *x, int *res, long long size, int iters){
     /* Pointer that can point to two arrays. The two arrays will be used as intermediate result arrays 
      * In each stage/iteration, one is used as input to be read and the other gets written with the result. 
      * At every next stage, they are switched, so that the result array is now read as input and the input array is overwrritten with the new result.  */
-    int **x_tmp = malloc(2 * sizeof(int*));
-    x_tmp[0] = malloc(2*size * sizeof(int)); /* allocate memory for the two arrays and assign them */
+    vec_t **x_tmp = malloc(2 * sizeof(vec_t*));
+    x_tmp[0] = malloc(2*size * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
     x_tmp[1] = &x_tmp[0][size]; /* assign the address of the second array to the pointer x_tmp_global[1] */
 
     /* Copy input x vector to intermediate x_tmp vector. */
@@ -31,8 +39,8 @@ void matvecs(int **A, int *x, int *res, long long size, int iters){
         x_tmp[0][i] = x[i];
     }
     
-    int *x_read;
-    int *x_write;
+    vec_t *x_read;
+    vec_t *x_write;
 
     for (r = 0; r < iters; r++) {
         x_read = x_tmp[r % 2];
@@ -57,7 +65,7 @@ void matvecs(int **A, int *x, int *res, long long size, int iters){
     return;
 }
 
-void matvecs_parallel(int **A, int *x, int *res, long long size, int iters, int thread_count) {
+void matvecs_parallel(value_t **A, vec_t *x, vec_t *res, long long size, int iters, int thread_count) {
     if (iters < 1) {
         /* Copy input vector to output vector. */
         for (long long i = 0; i < size; i++) {
@@ -69,8 +77,8 @@ void matvecs_parallel(int **A, int *x, int *res, long long size, int iters, int
     /* Global pointer that can point to two arrays. The two arrays will be used as intermediate result arrays 
      * In each stage/iteration, one is used as input to be read and the other gets written with the result. 
      * At every next stage, they are switched, so that the result array is now read as input and the input array is overwrritten with the new result.  */
-    int **x_tmp_global = malloc(2 * sizeof(int*));
-    x_tmp_global[0] = malloc(2 * size * sizeof(int)); /* allocate memory for the two arrays and assign them */
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * size * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
     x_tmp_global[1] = &x_tmp_global[0][size]; /* assign the address of the second array to the pointer x_tmp_global[1] */
 
     # pragma omp parallel num_threads(thread_count)
@@ -89,9 +97,9 @@ void matvecs_parallel(int **A, int *x, int *res, long long size, int iters, int
             x_tmp_global[0][i] = x[i]; /* (in case of parallel for) not a critical section because of different memory locations */
         }
         
-        int *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+        vec_t *x_read = NULL, *x_write = NULL;  /* local, temporary pointers */
         int  x_read_idx,     x_write_idx;       /* index to select one of the two intermediate results arrays */
-        int sum; /* private temporary variable */
+        vec_t sum; /* private temporary variable */
 
         for (int r = 0; r < iters; r++) {
             /* one index will be 0 and the other will be 1, interchanged after each iteration */
@@ -126,4 +134,160 @@ void matvecs_parallel(int **A, int *x, int *res, long long size, int iters, int
     free(x_tmp_global);
 
     return;
-}
\ No newline at end of file
+}
+
+/* Computes out[r] = A[r*lda + 0..n) . x for the NR <= MATVECS_DENSE_ROWS rows starting at A */
+typedef void (*rows_fn)(const value_t *A, long long lda, const vec_t *x, long long n, int nr, vec_t *out);
+
+static void rows_scalar(const value_t *A, long long lda, const vec_t *x, long long n, int nr, vec_t *out) {
+    for (int r = 0; r < nr; r++) {
+        const value_t *a = &A[r * lda];
+        vec_t sum = 0;
+        for (long long j = 0; j < n; j++) {
+            sum += a[j] * x[j];
+        }
+        out[r] = sum;
+    }
+}
+
+#ifdef MATVECS_X86
+/* NR is a constant at every call site, so the accumulators stay in registers */
+__attribute__((target("avx2"), always_inline))
+static inline void rows_avx2_n(const int *A, long long lda, const int *x, long long n, int nr, int *out) {
+    __m256i acc[MATVECS_DENSE_ROWS];
+    for (int r = 0; r < nr; r++) acc[r] = _mm256_setzero_si256();
+    long long j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i vx = _mm256_loadu_si256((const __m256i *) &x[j]);
+        for (int r = 0; r < nr; r++) {
+            __m256i va = _mm256_loadu_si256((const __m256i *) &A[r * lda + j]);
+            acc[r] = _mm256_add_epi32(acc[r], _mm256_mullo_epi32(va, vx)); /* wraps like the scalar int arithmetic */
+        }
+    }
+    for (int r = 0; r < nr; r++) {
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc[r]), _mm256_extracti128_si256(acc[r], 1));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+        s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+        int sum = _mm_cvtsi128_si32(s);
+        for (long long t = j; t < n; t++) {
+            sum += A[r * lda + t] * x[t];
+        }
+        out[r] = sum;
+    }
+}
+
+__attribute__((target("avx2")))
+static void rows_avx2(const int *A, long long lda, const int *x, long long n, int nr, int *out) {
+    switch (nr) {
+        case MATVECS_DENSE_ROWS: rows_avx2_n(A, lda, x, n, MATVECS_DENSE_ROWS, out); break;
+        default:                 for (int r = 0; r < nr; r++) rows_avx2_n(&A[r * lda], lda, x, n, 1, &out[r]);
+    }
+}
+
+/* The last partial vector of each row is a masked load, so there is no scalar tail */
+__attribute__((target("avx512f"), always_inline))
+static inline void rows_avx512_n(const int *A, long long lda, const int *x, long long n, int nr, int *out) {
+    __m512i acc[MATVECS_DENSE_ROWS];
+    for (int r = 0; r < nr; r++) acc[r] = _mm512_setzero_si512();
+    long long j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m512i vx = _mm512_loadu_si512((const void *) &x[j]);
+        for (int r = 0; r < nr; r++) {
+            __m512i va = _mm512_loadu_si512((const void *) &A[r * lda + j]);
+            acc[r] = _mm512_add_epi32(acc[r], _mm512_mullo_epi32(va, vx));
+        }
+    }
+    if (j < n) {
+        __mmask16 m = (__mmask16) ((1u << (n - j)) - 1);
+        __m512i vx = _mm512_maskz_loadu_epi32(m, &x[j]);
+        for (int r = 0; r < nr; r++) {
+            __m512i va = _mm512_maskz_loadu_epi32(m, &A[r * lda + j]);
+            acc[r] = _mm512_add_epi32(acc[r], _mm512_mullo_epi32(va, vx));
+        }
+    }
+    for (int r = 0; r < nr; r++) {
+        out[r] = _mm512_reduce_add_epi32(acc[r]);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void rows_avx512(const int *A, long long lda, const int *x, long long n, int nr, int *out) {
+    switch (nr) {
+        case MATVECS_DENSE_ROWS: rows_avx512_n(A, lda, x, n, MATVECS_DENSE_ROWS, out); break;
+        default:                 for (int r = 0; r < nr; r++) rows_avx512_n(&A[r * lda], lda, x, n, 1, &out[r]);
+    }
+}
+#endif
+
+/* Runtime CPU dispatch */
+static rows_fn select_rows(const char **isa) {
+    #ifdef MATVECS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        if (isa) *isa = "avx512";
+        return rows_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        if (isa) *isa = "avx2";
+        return rows_avx2;
+    }
+    #endif
+    if (isa) *isa = "scalar";
+    return rows_scalar;
+}
+
+const char *matvecs_dense_isa(void) {
+    const char *isa;
+    select_rows(&isa);
+    return isa;
+}
+
+void matvecs_dense(const value_t *A, vec_t *x, vec_t *res, long long size, int iters, int thread_count) {
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < size; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    rows_fn rows = select_rows(NULL);
+    long long nblocks = (size + MATVECS_DENSE_ROWS - 1) / MATVECS_DENSE_ROWS;
+    vec_t *x_tmp_global[2];
+    x_tmp_global[0] = malloc(2 * size * sizeof(vec_t));
+    if (!x_tmp_global[0]) {
+        perror("malloc x_tmp_global");
+        exit(EXIT_FAILURE);
+    }
+    x_tmp_global[1] = &x_tmp_global[0][size];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        # pragma omp single
+        for (long long i = 0; i < size; i++) {
+            x_tmp_global[0][i] = x[i];
+        }
+
+        vec_t *x_write = NULL;
+        for (int r = 0; r < iters; r++) {
+            const vec_t *x_read = x_tmp_global[r % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            /* The static schedule gives every thread the same row blocks at every step */
+            # pragma omp for schedule(static)
+            for (long long b = 0; b < nblocks; b++) {
+                long long i = b * MATVECS_DENSE_ROWS;
+                int nr = size - i < MATVECS_DENSE_ROWS ? (int) (size - i) : MATVECS_DENSE_ROWS;
+                rows(&A[i * size], size, x_read, size, nr, &x_write[i]);
+            } /* implicit barrier */
+        }
+
+        # pragma omp single
+        for (long long i = 0; i < size; i++) {
+            res[i] = x_write[i];
+        }
+    }
+
+    free(x_tmp_global[0]);
+    return;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "matvecs_bcsr.h"
+#include "sparse_matrix_bcsr.h"
+
+/* Multiplies block row B of A with x into rows [B*r, B*r + r) of y */
+typedef void (*brow_fn)(const struct sparse_matrix_bcsr *A, long long b, const vec_t *x, vec_t *y);
+
+/* Kernel for R x C blocks. With constant sizes the compiler fully unrolls the block, keeps the R sums and the
+ * C entries of x in registers for the whole block row, and vectorizes the wider blocks. */
+#define DEFINE_BCSR_BROW(R, C)                                                                      \
+static void brow_##R##x##C(const struct sparse_matrix_bcsr *A, long long b, const vec_t *x, vec_t *y) { \
+    vec_t acc[R] = {0};                                                                               \
+    for (long long k = A->brow_ptr[b]; k < A->brow_ptr[b+1]; k++) {                                 \
+        const value_t *v = &A->values[k * (R*C)];                                                       \
+        const vec_t *xb = &x[(long long) A->bcol[k] * C];                                             \
+        for (int i = 0; i < R; i++)                                                                 \
+            for (int j = 0; j < C; j++)                                                             \
+                acc[i] += v[i*C + j] * xb[j];                                                       \
+    }                                                                                               \
+    for (int i = 0; i < R; i++)                                                                     \
+        y[b*R + i] = acc[i];                                                                        \
+}
+
+DEFINE_BCSR_BROW(1, 1)
+DEFINE_BCSR_BROW(1, 2)
+DEFINE_BCSR_BROW(2, 1)
+DEFINE_BCSR_BROW(2, 2)
+DEFINE_BCSR_BROW(3, 3)
+DEFINE_BCSR_BROW(4, 1)
+DEFINE_BCSR_BROW(1, 4)
+DEFINE_BCSR_BROW(2, 4)
+DEFINE_BCSR_BROW(4, 2)
+DEFINE_BCSR_BROW(4, 4)
+DEFINE_BCSR_BROW(8, 1)
+
+/* Any other block size */
+static void brow_generic(const struct sparse_matrix_bcsr *A, long long b, const vec_t *x, vec_t *y) {
+    int r = A->r, c = A->c;
+    vec_t *yb = &y[b * r];
+    for (int i = 0; i < r; i++) {
+        yb[i] = 0;
+    }
+    for (long long k = A->brow_ptr[b]; k < A->brow_ptr[b+1]; k++) {
+        const value_t *v = &A->values[k * r * c];
+        const vec_t *xb = &x[(long long) A->bcol[k] * c];
+        for (int i = 0; i < r; i++) {
+            for (int j = 0; j < c; j++) {
+                yb[i] += v[i*c + j] * xb[j];
+            }
+        }
+    }
+}
+
+/* Same order as BCSR_BLOCK_SIZES */
+static const brow_fn brow_kernels[BCSR_NUM_BLOCK_SIZES] = {
+    brow_1x1, brow_1x2, brow_2x1, brow_2x2, brow_3x3, brow_4x1, brow_1x4, brow_2x4, brow_4x2, brow_4x4, brow_8x1
+};
+
+static brow_fn select_brow(int r, int c) {
+    const int sizes[2 * BCSR_NUM_BLOCK_SIZES] = BCSR_BLOCK_SIZES;
+    for (int s = 0; s < BCSR_NUM_BLOCK_SIZES; s++) {
+        if (sizes[2*s] == r && sizes[2*s + 1] == c) return brow_kernels[s];
+    }
+    return brow_generic;
+}
+
+int matvecs_bcsr_unrolled(int r, int c) {
+    return select_brow(r, c) != brow_generic;
+}
+
+/* Length of the intermediate vectors: the last block row and block column may extend past the matrix.
+ * The extra entries of x are zeros (multiplied by the zero padding of the blocks) and those of y receive zeros. */
+static long long padded_length(const struct sparse_matrix_bcsr *A) {
+    long long py = A->brows * A->r;
+    long long px = (A->rows + A->c - 1) / A->c * A->c;
+    return py > px ? py : px;
+}
+
+void matvecs_bcsr(struct sparse_matrix_bcsr *A, vec_t *x, vec_t *res, int iters) {
+    long long cols = A->rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    brow_fn brow = select_brow(A->r, A->c);
+    long long len = padded_length(A);
+
+    /* Two intermediate result arrays, switched at every iteration (as in matvecs_csr) */
+    vec_t **x_tmp = malloc(2 * sizeof(vec_t*));
+    x_tmp[0] = calloc(2 * len, sizeof(vec_t)); /* zero padding */
+    x_tmp[1] = &x_tmp[0][len];
+    memcpy(x_tmp[0], x, cols * sizeof(vec_t));
+
+    vec_t *x_read = NULL, *x_write = NULL;
+    for (int r = 0; r < iters; r++) {
+        x_read  = x_tmp[     r  % 2];
+        x_write = x_tmp[(r + 1) % 2];
+        for (long long b = 0; b < A->brows; b++) {
+            brow(A, b, x_read, x_write);
+        }
+    }
+
+    /* Copy result to output memory */
+    memcpy(res, x_write, cols * sizeof(vec_t));
+
+    /* Free allocated memory */
+    free(x_tmp[0]);
+    free(x_tmp);
+
+    return;
+}
+
+void matvecs_bcsr_parallel(struct sparse_matrix_bcsr *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long cols = A->rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    brow_fn brow = select_brow(A->r, A->c);
+    long long len = padded_length(A);
+
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = calloc(2 * len, sizeof(vec_t)); /* allocate memory for the two arrays, with zero padding */
+    x_tmp_global[1] = &x_tmp_global[0][len];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Copy input x vector to intermediate x_tmp_global vector. */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            x_tmp_global[0][i] = x[i];
+        }
+
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+
+        for (int r = 0; r < iters; r++) {
+            x_read  = x_tmp_global[     r  % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            # pragma omp for schedule(static)
+            for (long long b = 0; b < A->brows; b++) {
+                brow(A, b, x_read, x_write);
+            } /* implicit barrier */
+        }
+
+        /* Copy final result to output memory */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x_write[i];
+        }
+    }
+
+    /* Free allocated memory */
+    free(x_tmp_global[0]);
+    free(x_tmp_global);
+
+    return;
+}
@@ -6,9 +6,10 @@
 
 #include "matvecs_csr.h"
 #include "sparse_matrix_csr.h"
+#include "csr_powers.h"
 // #include "util_matvec.h"
 
-void matvecs_csr(struct sparse_matrix_csr *A_csr, int *x, int *res, int iters){
+void matvecs_csr(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters){
     long long i, j;
     int r;
     long long rows = A_csr->rows;
@@ -25,8 +26,8 @@ void matvecs_csr(struct sparse_matrix_csr *A_csr, int *x, int *res, int iters){
     /* Pointer that can point to two arrays. The two arrays will be used as intermediate result arrays 
      * In each stage/iteration, one is used as input to be read and the other gets written with the result. 
      * At every next stage, they are switched, so that the result array is now read as input and the input array is overwrritten with the new result.  */
-    int **x_tmp = malloc(2 * sizeof(int*));
-    x_tmp[0] = malloc(2*cols * sizeof(int));
+    vec_t **x_tmp = malloc(2 * sizeof(vec_t*));
+    x_tmp[0] = malloc(2*cols * sizeof(vec_t));
     x_tmp[1] = &x_tmp[0][cols];
 
     /* Copy input x vector to intermediate x_tmp vector. */
@@ -34,8 +35,8 @@ void matvecs_csr(struct sparse_matrix_csr *A_csr, int *x, int *res, int iters){
         x_tmp[0][i] = x[i];
     }
     
-    int *x_read;
-    int *x_write;
+    vec_t *x_read;
+    vec_t *x_write;
 
     #ifdef DEBUG
     double t_start, t_end;
@@ -72,7 +73,7 @@ void matvecs_csr(struct sparse_matrix_csr *A_csr, int *x, int *res, int iters){
     return;
 }
 
-void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, int *x, int *res, int iters, int thread_count) {
+void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters, int thread_count) {
     long long rows = A_csr->rows;
     long long cols = rows; /* cols = rows for square matrix */
 
@@ -87,8 +88,8 @@ void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, int *x, int *res, int
     /* Global pointer that can point to two arrays. The two arrays will be used as intermediate result arrays 
      * In each stage/iteration, one is used as input to be read and the other as the result to be written. 
      * At the start of every stage, they are switched, so that the result array is now read as input and the input array is overwrritten with the new result. */
-    int **x_tmp_global = malloc(2 * sizeof(int*));
-    x_tmp_global[0] = malloc(2 * cols * sizeof(int)); /* allocate memory for the two arrays and assign them */
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * cols * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
     x_tmp_global[1] = &x_tmp_global[0][cols]; /* assign the address of the beginning of the second array to the pointer x_tmp_global[1] */
 
     # pragma omp parallel num_threads(thread_count)
@@ -105,15 +106,17 @@ void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, int *x, int *res, int
         double t_start, t_end;
         #endif
 
-        /* Copy input x vector to intermediate x_tmp_global vector. */
-        # pragma omp single /* omp single: better when cols are few, omp for: better when cols are a lot */
+        /* Copy input x vector to intermediate x_tmp_global vector. 
+         * With the static row schedule of the multiplications, so that each thread first touches (and places on its NUMA node) 
+         * the part of the vectors it writes. */
+        # pragma omp for schedule(static)
         for (long long i = 0; i < cols; i++) {
-            x_tmp_global[0][i] = x[i]; /* (in case of parallel for) not a critical section because of different memory locations */
-        }
+            x_tmp_global[0][i] = x[i]; /* not a critical section because of different memory locations */
+        } /* implicit barrier */
         
-        int *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
         int  x_read_idx,     x_write_idx;       /* index to select one of the two intermediate results arrays */
-        int sum; /* private temporary variable */
+        vec_t sum; /* private temporary variable */
 
         for (int r = 0; r < iters; r++) {
             /* one index will be 0 and the other will be 1, interchanged after each iteration */
@@ -150,10 +153,10 @@ void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, int *x, int *res, int
         #ifdef DEBUG
         t_start = omp_get_wtime();
         #endif
-        /* Copy final result to output memory */
-        # pragma omp single /* omp single: better when cols are few, omp for: better when cols are a lot */
+        /* Copy final result to output memory, each thread the rows it computed */
+        # pragma omp for schedule(static)
         for (long long i = 0; i < cols; i++) {
-            res[i] = x_write[i]; /* (in case of parallel for) not a critical section because of different memory locations */
+            res[i] = x_write[i]; /* not a critical section because of different memory locations */
         }
 
         #ifdef DEBUG
@@ -170,4 +173,264 @@ void matvecs_csr_parallel(struct sparse_matrix_csr *A_csr, int *x, int *res, int
     free(x_tmp_global);
 
     return;
-}
\ No newline at end of file
+}
+
+void matvecs_csr_balanced(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long cols = A_csr->rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    /* Row ranges of equal work, computed once for all the iterations (and kept for later calls) */
+    const struct csr_partition *part = csr_row_partition(A_csr, thread_count);
+
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * cols * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
+    x_tmp_global[1] = &x_tmp_global[0][cols];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Copy input x vector to intermediate x_tmp_global vector. */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            x_tmp_global[0][i] = x[i];
+        }
+
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+        vec_t sum; /* private temporary variable */
+
+        for (int r = 0; r < iters; r++) {
+            x_read  = x_tmp_global[     r  % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            /* One part per thread (or several if the team is smaller than thread_count) */
+            # pragma omp for schedule(static, 1)
+            for (int p = 0; p < part->nparts; p++) {
+                for (long long i = part->row_start[p]; i < part->row_start[p+1]; i++) {
+                    sum = 0;
+                    for (long long j = A_csr->row_ptr[i]; j < A_csr->row_ptr[i+1]; j++) {
+                        sum += A_csr->values[j] * x_read[A_csr->col_index[j]];
+                    }
+                    x_write[i] = sum;
+                }
+            } /* implicit barrier */
+        }
+
+        /* Copy final result to output memory */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x_write[i];
+        }
+    }
+
+    /* Free allocated memory */
+    free(x_tmp_global[0]);
+    free(x_tmp_global);
+
+    return;
+}
+
+void matvecs_csr_merge(struct sparse_matrix_csr *A_csr, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long rows = A_csr->rows;
+    long long cols = rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    /* Merge-path coordinates, computed once for all the iterations (and kept for later calls) */
+    const struct csr_partition *part = csr_merge_partition(A_csr, thread_count);
+    int nparts = part->nparts;
+
+    /* Partial sum of the row each part ends in the middle of, added to that row once all parts are done */
+    long long *carry_row = malloc(nparts * sizeof(long long));
+    vec_t *carry_val = malloc(nparts * sizeof(vec_t));
+
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * cols * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
+    x_tmp_global[1] = &x_tmp_global[0][cols];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Copy input x vector to intermediate x_tmp_global vector. */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            x_tmp_global[0][i] = x[i];
+        }
+
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+        vec_t sum; /* private temporary variable */
+
+        for (int r = 0; r < iters; r++) {
+            x_read  = x_tmp_global[     r  % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            # pragma omp for schedule(static, 1)
+            for (int p = 0; p < nparts; p++) {
+                long long j = part->nz_start[p];
+                long long row_end = part->row_start[p+1];
+
+                /* Rows completed by this part. The first one may have started in a previous part. */
+                for (long long i = part->row_start[p]; i < row_end; i++) {
+                    sum = 0;
+                    for (; j < A_csr->row_ptr[i+1]; j++) {
+                        sum += A_csr->values[j] * x_read[A_csr->col_index[j]];
+                    }
+                    x_write[i] = sum;
+                }
+
+                /* Beginning of the row that the next part completes */
+                sum = 0;
+                for (; j < part->nz_start[p+1]; j++) {
+                    sum += A_csr->values[j] * x_read[A_csr->col_index[j]];
+                }
+                carry_row[p] = row_end;
+                carry_val[p] = sum;
+            } /* implicit barrier */
+
+            /* Fix-up of the split rows, in part order (a row may be split among several parts) */
+            # pragma omp single
+            for (int p = 0; p < nparts; p++) {
+                if (carry_row[p] < rows)
+                    x_write[carry_row[p]] += carry_val[p];
+            } /* implicit barrier */
+        }
+
+        /* Copy final result to output memory */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x_write[i];
+        }
+    }
+
+    /* Free allocated memory */
+    free(x_tmp_global[0]);
+    free(x_tmp_global);
+    free(carry_row);
+    free(carry_val);
+
+    return;
+}
+
+void matvecs_csr_powers(struct sparse_matrix_csr *A_csr, const struct csr_powers_plan *plan, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long cols = A_csr->rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    if (plan->s < 2) {
+        /* No affordable fusion */
+        matvecs_csr_parallel(A_csr, x, res, iters, thread_count);
+        return;
+    }
+    int s = plan->s;
+    int rounds = (iters + s - 1) / s;
+
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * cols * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
+    x_tmp_global[1] = &x_tmp_global[0][cols];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Local vectors of the block being computed: the values of step k-1 are read from v_prev, step k written to v_next */
+        vec_t *v_prev = malloc((plan->max_local + 1) * sizeof(vec_t));
+        vec_t *v_next = malloc((plan->max_local + 1) * sizeof(vec_t));
+
+        /* Copy input x vector to intermediate x_tmp_global vector. */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            x_tmp_global[0][i] = x[i];
+        }
+
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+
+        for (int r = 0; r < rounds; r++) {
+            x_read  = x_tmp_global[     r  % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+            int steps = r < rounds - 1 ? s : iters - r * s; /* the last round may be shorter */
+
+            # pragma omp for schedule(dynamic, 1)
+            for (long long b = 0; b < plan->nblocks; b++) {
+                const struct csr_powers_block *blk = &plan->blocks[b];
+
+                for (long long l = 0; l < blk->nlocal; l++) {
+                    v_prev[l] = x_read[blk->ids[l]];
+                }
+                /* A round of STEPS < s steps only needs the rows of level >= s - STEPS + k at its step k */
+                for (int k = 1; k <= steps; k++) {
+                    long long nrows = blk->count[s - steps + k];
+                    for (long long i = 0; i < nrows; i++) {
+                        vec_t sum = 0;
+                        for (long long j = blk->row_ptr[i]; j < blk->row_ptr[i+1]; j++) {
+                            sum += blk->values[j] * v_prev[blk->col[j]];
+                        }
+                        v_next[i] = sum;
+                    }
+                    vec_t *tmp = v_prev;
+                    v_prev = v_next;
+                    v_next = tmp;
+                }
+                /* Owned rows come first */
+                for (long long i = 0; i < blk->count[s]; i++) {
+                    x_write[blk->row_lo + i] = v_prev[i];
+                }
+            } /* implicit barrier */
+        }
+
+        /* Copy final result to output memory */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x_write[i];
+        }
+
+        free(v_prev);
+        free(v_next);
+    }
+
+    /* Free allocated memory */
+    free(x_tmp_global[0]);
+    free(x_tmp_global);
+
+    return;
+}
+
+void matvecs_csr_reordered(struct csr_reordered *R, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long cols = R->mtx->rows; /* cols = rows for square matrix */
+    vec_t *x_perm   = malloc(cols * sizeof(vec_t));
+    vec_t *res_perm = malloc(cols * sizeof(vec_t));
+    if (!x_perm || !res_perm) {
+        perror("malloc permuted vectors");
+        exit(EXIT_FAILURE);
+    }
+
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long long i = 0; i < cols; i++) {
+        x_perm[i] = x[R->perm[i]];
+    }
+
+    matvecs_csr_parallel(R->mtx, x_perm, res_perm, iters, thread_count);
+
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long long i = 0; i < cols; i++) {
+        res[R->perm[i]] = res_perm[i];
+    }
+
+    free(x_perm);
+    free(res_perm);
+
+    return;
+}
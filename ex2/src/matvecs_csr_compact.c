@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "matvecs_csr_compact.h"
+#include "sparse_matrix_csr_compact.h"
+
+/* Row i of A times x, with 32-bit column indices */
+static inline vec_t row_u32(const struct sparse_matrix_csr_compact *A, long long i, const vec_t *x) {
+    vec_t sum = 0;
+    for (long long j = A->row_ptr[i]; j < A->row_ptr[i+1]; j++) {
+        sum += A->values[j] * x[A->col_index[j]];
+    }
+    return sum;
+}
+
+/* Row i of A times x, decoding the column deltas of WIDTH bytes (a separate loop per width keeps the decoding branch-free) */
+#define ROW_DELTA_LOOP(TYPE)                                        \
+    for (long long k = 1; k < len; k++) {                           \
+        TYPE d;                                                     \
+        memcpy(&d, &src[(k-1) * sizeof(TYPE)], sizeof(TYPE));      \
+        c += d;                                                     \
+        sum += v[k] * x[c];                                         \
+    }
+
+static inline vec_t row_delta(const struct sparse_matrix_csr_compact *A, long long i, const vec_t *x) {
+    long long len = A->row_ptr[i+1] - A->row_ptr[i];
+    if (len == 0) return 0;
+    const value_t *v = &A->values[A->row_ptr[i]];
+    const uint8_t *src = &A->deltas[A->delta_ptr[i]];
+    uint32_t c = A->row_base[i];
+    vec_t sum = v[0] * x[c];
+    switch (A->row_width[i]) {
+        case 1:  ROW_DELTA_LOOP(uint8_t);  break;
+        case 2:  ROW_DELTA_LOOP(uint16_t); break;
+        default: ROW_DELTA_LOOP(uint32_t);
+    }
+    return sum;
+}
+
+void matvecs_csr_compact(struct sparse_matrix_csr_compact *A, vec_t *x, vec_t *res, int iters) {
+    long long rows = A->rows;
+    long long cols = rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    /* Two intermediate result arrays, switched at every iteration (as in matvecs_csr) */
+    vec_t **x_tmp = malloc(2 * sizeof(vec_t*));
+    x_tmp[0] = malloc(2 * cols * sizeof(vec_t));
+    x_tmp[1] = &x_tmp[0][cols];
+    memcpy(x_tmp[0], x, cols * sizeof(vec_t));
+
+    vec_t *x_read = NULL, *x_write = NULL;
+    for (int r = 0; r < iters; r++) {
+        x_read  = x_tmp[     r  % 2];
+        x_write = x_tmp[(r + 1) % 2];
+        if (A->encoding == CSR_COMPACT_U32) {
+            for (long long i = 0; i < rows; i++) {
+                x_write[i] = row_u32(A, i, x_read);
+            }
+        } else {
+            for (long long i = 0; i < rows; i++) {
+                x_write[i] = row_delta(A, i, x_read);
+            }
+        }
+    }
+
+    /* Copy result to output memory */
+    memcpy(res, x_write, cols * sizeof(vec_t));
+
+    /* Free allocated memory */
+    free(x_tmp[0]);
+    free(x_tmp);
+
+    return;
+}
+
+void matvecs_csr_compact_parallel(struct sparse_matrix_csr_compact *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long rows = A->rows;
+    long long cols = rows; /* cols = rows for square matrix */
+    int delta = A->encoding == CSR_COMPACT_DELTA;
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * cols * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
+    x_tmp_global[1] = &x_tmp_global[0][cols];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Copy input x vector to intermediate x_tmp_global vector. */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            x_tmp_global[0][i] = x[i];
+        }
+
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+
+        for (int r = 0; r < iters; r++) {
+            x_read  = x_tmp_global[     r  % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            if (delta) {
+                # pragma omp for schedule(static)
+                for (long long i = 0; i < rows; i++) {
+                    x_write[i] = row_delta(A, i, x_read);
+                } /* implicit barrier */
+            } else {
+                # pragma omp for schedule(static)
+                for (long long i = 0; i < rows; i++) {
+                    x_write[i] = row_u32(A, i, x_read);
+                } /* implicit barrier */
+            }
+        }
+
+        /* Copy final result to output memory */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x_write[i];
+        }
+    }
+
+    /* Free allocated memory */
+    free(x_tmp_global[0]);
+    free(x_tmp_global);
+
+    return;
+}
@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "matvecs_csr_sym.h"
+#include "sparse_matrix_csr_sym.h"
+
+/* y = A x on the rows [lo, hi): row i adds its stored elements to y[i], and its mirrored ones to y[j] if j < hi,
+ * else to spill[j - hi]. y[lo, hi) and spill must be zero on entry. */
+static inline void sym_rows(const struct sparse_matrix_csr_sym *A, long long lo, long long hi, const vec_t *x, vec_t *y, vec_t *spill) {
+    const long long *row_ptr = A->row_ptr;
+    const long long *col_index = A->col_index;
+    const value_t *values = A->values;
+    for (long long i = lo; i < hi; i++) {
+        long long k = row_ptr[i], end = row_ptr[i+1];
+        vec_t xi = x[i];
+        vec_t sum = 0;
+        if (k < end && col_index[k] == i) { /* diagonal, first when present */
+            sum = values[k] * xi;
+            k++;
+        }
+        for (; k < end; k++) {
+            long long j = col_index[k];
+            value_t a = values[k];
+            sum += a * x[j];
+            if (j < hi)
+                y[j] += a * xi;
+            else
+                spill[j - hi] += a * xi;
+        }
+        y[i] += sum;
+    }
+}
+
+void matvecs_csr_sym(struct sparse_matrix_csr_sym *A, vec_t *x, vec_t *res, int iters) {
+    long long rows = A->rows;
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < rows; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    vec_t *x_tmp[2];
+    x_tmp[0] = malloc(2 * rows * sizeof(vec_t));
+    if (!x_tmp[0]) {
+        perror("malloc x_tmp");
+        exit(EXIT_FAILURE);
+    }
+    x_tmp[1] = &x_tmp[0][rows];
+
+    for (long long i = 0; i < rows; i++) {
+        x_tmp[0][i] = x[i];
+    }
+
+    vec_t *x_write = x_tmp[0];
+    for (int r = 0; r < iters; r++) {
+        vec_t *x_read = x_tmp[r % 2];
+        x_write = x_tmp[(r + 1) % 2];
+        for (long long i = 0; i < rows; i++) {
+            x_write[i] = 0;
+        }
+        sym_rows(A, 0, rows, x_read, x_write, NULL); /* every column is below rows: nothing spills */
+    }
+
+    for (long long i = 0; i < rows; i++) {
+        res[i] = x_write[i];
+    }
+
+    free(x_tmp[0]);
+}
+
+void matvecs_csr_sym_parallel(struct sparse_matrix_csr_sym *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long rows = A->rows;
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < rows; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    int nparts = csr_sym_partition(A, thread_count);
+    const long long *part_start = A->part_start;
+    const long long *part_col_end = A->part_col_end;
+
+    /* Spill vector of part p: spill[spill_off[p] + j - part_start[p+1]] for the rows j in [part_start[p+1], part_col_end[p]) */
+    long long *spill_off = malloc((nparts + 1) * sizeof(long long));
+    if (!spill_off) {
+        perror("malloc spill_off");
+        exit(EXIT_FAILURE);
+    }
+    spill_off[0] = 0;
+    for (int p = 0; p < nparts; p++) {
+        spill_off[p+1] = spill_off[p] + (part_col_end[p] - part_start[p+1]);
+    }
+
+    vec_t *x_tmp_global[2];
+    x_tmp_global[0] = malloc(2 * rows * sizeof(vec_t));
+    vec_t *spill = malloc((spill_off[nparts] > 0 ? spill_off[nparts] : 1) * sizeof(vec_t));
+    if (!x_tmp_global[0] || !spill) {
+        perror("malloc x_tmp_global");
+        exit(EXIT_FAILURE);
+    }
+    x_tmp_global[1] = &x_tmp_global[0][rows];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        # pragma omp for schedule(static, 1)
+        for (int p = 0; p < nparts; p++) {
+            for (long long i = part_start[p]; i < part_start[p+1]; i++) {
+                x_tmp_global[0][i] = x[i];
+            }
+        }
+
+        vec_t *x_write = NULL;
+        for (int r = 0; r < iters; r++) {
+            const vec_t *x_read = x_tmp_global[r % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            /* Own rows, and the spilled mirrored contributions */
+            # pragma omp for schedule(static, 1)
+            for (int p = 0; p < nparts; p++) {
+                long long lo = part_start[p], hi = part_start[p+1];
+                vec_t *my_spill = &spill[spill_off[p]];
+                for (long long i = lo; i < hi; i++) x_write[i] = 0;
+                for (long long k = 0; k < spill_off[p+1] - spill_off[p]; k++) my_spill[k] = 0;
+                sym_rows(A, lo, hi, x_read, x_write, my_spill);
+            } /* implicit barrier: all the spills are complete */
+
+            /* Each part adds the spills of the previous parts that reach its rows */
+            # pragma omp for schedule(static, 1)
+            for (int p = 0; p < nparts; p++) {
+                long long lo = part_start[p], hi = part_start[p+1];
+                for (int q = 0; q < p; q++) {
+                    long long from = part_start[q+1] > lo ? part_start[q+1] : lo;
+                    long long to   = part_col_end[q] < hi ? part_col_end[q] : hi;
+                    const vec_t *s = &spill[spill_off[q]];
+                    for (long long j = from; j < to; j++) {
+                        x_write[j] += s[j - part_start[q+1]];
+                    }
+                }
+            } /* implicit barrier */
+        }
+
+        # pragma omp for schedule(static, 1)
+        for (int p = 0; p < nparts; p++) {
+            for (long long i = part_start[p]; i < part_start[p+1]; i++) {
+                res[i] = x_write[i];
+            }
+        }
+    }
+
+    free(spill);
+    free(spill_off);
+    free(x_tmp_global[0]);
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "value_type.h"
+
+/* The gather kernels are int32 only */
+#if (defined(__x86_64__) || defined(__i386__)) && VALUE_IS_INT
+#define MATVECS_SELL_X86
+#include <immintrin.h>
+#endif
+
+#include "matvecs_sell.h"
+#include "sparse_matrix_sell.h"
+
+/* Multiplies slice S of A with x and writes the C results to their original rows of y */
+typedef void (*slice_fn)(const struct sparse_matrix_sell *A, long long s, const vec_t *x, vec_t *y);
+
+/* Scatters the C sums of slice S back to the original row order, skipping the padding rows */
+static inline void store_slice(const struct sparse_matrix_sell *A, long long s, const vec_t *acc, vec_t *y) {
+    const long long *perm = &A->perm[s * A->C];
+    for (int l = 0; l < A->C; l++) {
+        if (perm[l] >= 0) y[perm[l]] = acc[l];
+    }
+}
+
+static void slice_scalar(const struct sparse_matrix_sell *A, long long s, const vec_t *x, vec_t *y) {
+    int C = A->C;
+    long long off = A->slice_ptr[s];
+    long long width = (A->slice_ptr[s+1] - off) / C;
+    const value_t *val = &A->values[off];
+    const int *col = &A->col_index[off];
+    vec_t acc[SELL_MAX_C] = {0};
+    for (long long k = 0; k < width; k++) {
+        for (int l = 0; l < C; l++) {
+            acc[l] += val[k*C + l] * x[col[k*C + l]];
+        }
+    }
+    store_slice(A, s, acc, y);
+}
+
+#ifdef MATVECS_SELL_X86
+/* C = 8: one 8-lane gather of x per column of the slice */
+__attribute__((target("avx2")))
+static void slice_avx2(const struct sparse_matrix_sell *A, long long s, const int *x, int *y) {
+    long long off = A->slice_ptr[s];
+    long long width = (A->slice_ptr[s+1] - off) / 8;
+    const int *val = &A->values[off];
+    const int *col = &A->col_index[off];
+    __m256i acc = _mm256_setzero_si256();
+    for (long long k = 0; k < width; k++) {
+        __m256i vv = _mm256_loadu_si256((const __m256i *) &val[8*k]);
+        __m256i vc = _mm256_loadu_si256((const __m256i *) &col[8*k]);
+        __m256i vx = _mm256_i32gather_epi32(x, vc, 4);
+        acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(vv, vx)); /* wraps like the scalar int arithmetic */
+    }
+    int out[8];
+    _mm256_storeu_si256((__m256i *) out, acc);
+    store_slice(A, s, out, y);
+}
+
+/* C = 16: one 16-lane gather of x per column of the slice */
+__attribute__((target("avx512f")))
+static void slice_avx512(const struct sparse_matrix_sell *A, long long s, const int *x, int *y) {
+    long long off = A->slice_ptr[s];
+    long long width = (A->slice_ptr[s+1] - off) / 16;
+    const int *val = &A->values[off];
+    const int *col = &A->col_index[off];
+    __m512i acc = _mm512_setzero_si512();
+    for (long long k = 0; k < width; k++) {
+        __m512i vv = _mm512_loadu_si512((const void *) &val[16*k]);
+        __m512i vc = _mm512_loadu_si512((const void *) &col[16*k]);
+        __m512i vx = _mm512_i32gather_epi32(vc, x, 4);
+        acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(vv, vx));
+    }
+    int out[16];
+    _mm512_storeu_si512((void *) out, acc);
+    store_slice(A, s, out, y);
+}
+#endif
+
+/* Runtime CPU dispatch on the slice height */
+static slice_fn select_slice(int C, const char **isa) {
+    #ifdef MATVECS_SELL_X86
+    __builtin_cpu_init();
+    if (C == 16 && __builtin_cpu_supports("avx512f")) {
+        if (isa) *isa = "avx512";
+        return slice_avx512;
+    }
+    if (C == 8 && __builtin_cpu_supports("avx2")) {
+        if (isa) *isa = "avx2";
+        return slice_avx2;
+    }
+    #else
+    (void) C; /* the scalar kernel takes any slice height */
+    #endif
+    if (isa) *isa = "scalar";
+    return slice_scalar;
+}
+
+int matvecs_sell_default_c(void) {
+    #ifdef MATVECS_SELL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return 16;
+    #endif
+    return 8;
+}
+
+const char *matvecs_sell_isa(int C) {
+    const char *isa;
+    select_slice(C, &isa);
+    return isa;
+}
+
+void matvecs_sell(struct sparse_matrix_sell *A_sell, vec_t *x, vec_t *res, int iters) {
+    long long cols = A_sell->rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    slice_fn slice = select_slice(A_sell->C, NULL);
+
+    /* Two intermediate result arrays, switched at every iteration (as in matvecs_csr) */
+    vec_t **x_tmp = malloc(2 * sizeof(vec_t*));
+    x_tmp[0] = malloc(2 * cols * sizeof(vec_t));
+    x_tmp[1] = &x_tmp[0][cols];
+    memcpy(x_tmp[0], x, cols * sizeof(vec_t));
+
+    vec_t *x_read = NULL, *x_write = NULL;
+    for (int r = 0; r < iters; r++) {
+        x_read  = x_tmp[     r  % 2];
+        x_write = x_tmp[(r + 1) % 2];
+        for (long long s = 0; s < A_sell->nslices; s++) {
+            slice(A_sell, s, x_read, x_write);
+        }
+    }
+
+    /* Copy result to output memory */
+    memcpy(res, x_write, cols * sizeof(vec_t));
+
+    /* Free allocated memory */
+    free(x_tmp[0]);
+    free(x_tmp);
+
+    return;
+}
+
+void matvecs_sell_parallel(struct sparse_matrix_sell *A_sell, vec_t *x, vec_t *res, int iters, int thread_count) {
+    long long cols = A_sell->rows; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vector to output vector. */
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x[i];
+        }
+        return;
+    }
+
+    slice_fn slice = select_slice(A_sell->C, NULL);
+
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * cols * sizeof(vec_t)); /* allocate memory for the two arrays and assign them */
+    x_tmp_global[1] = &x_tmp_global[0][cols];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Copy input x vector to intermediate x_tmp_global vector. */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            x_tmp_global[0][i] = x[i];
+        }
+
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+
+        for (int r = 0; r < iters; r++) {
+            x_read  = x_tmp_global[     r  % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            /* Each slice writes its own (permuted) rows: no conflicts between threads */
+            # pragma omp for schedule(dynamic, 16)
+            for (long long s = 0; s < A_sell->nslices; s++) {
+                slice(A_sell, s, x_read, x_write);
+            } /* implicit barrier */
+        }
+
+        /* Copy final result to output memory */
+        # pragma omp single
+        for (long long i = 0; i < cols; i++) {
+            res[i] = x_write[i];
+        }
+    }
+
+    /* Free allocated memory */
+    free(x_tmp_global[0]);
+    free(x_tmp_global);
+
+    return;
+}
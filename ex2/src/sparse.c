@@ -1,34 +1,152 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h> /* getopt */
 
 #include "gen_int_array.h"
 #include "gen_sparse_matrix.h"
 #include "sparse_matrix_csr.h"
 #include "matvecs.h"
 #include "matvecs_csr.h"
+#include "csr_powers.h"
+#include "csr_reorder.h"
+#include "csr_io.h"
+#include "csr_spmv_plan.h"
+#include "csr_numa.h"
+#include "spmm_csr.h"
+#include "sparse_matrix_csr_compact.h"
+#include "matvecs_csr_compact.h"
+#include "sparse_matrix_bcsr.h"
+#include "matvecs_bcsr.h"
+#include "sparse_matrix_sell.h"
+#include "matvecs_sell.h"
+#include "sparse_matrix_csr_sym.h"
+#include "matvecs_csr_sym.h"
 #include "util_matvec.h"
 
+/* Default number of multiplications fused by the matrix-powers kernel */
+#define POWERS_DEFAULT_STEPS 4
+
+/* Default number of vectors multiplied together by SpMM */
+#define SPMM_DEFAULT_VECTORS 8
+
+/* Default sorting window of the SELL-C-sigma format */
+#define SELL_DEFAULT_SIGMA 256
+
+/* Signature shared by the repeated sparse matrix-vector multiplication variants, A being the matrix in the variant's format */
+typedef void (*matvecs_fn)(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+
+/* Matrix of the matrix-powers variant, with the plan built for it */
+struct powers_variant {
+    struct sparse_matrix_csr *A;
+    const struct csr_powers_plan *plan;
+};
+
 void Usage(char* prog_name);
+long long run_variant(const char *name, matvecs_fn fn, void *A, long long rows, vec_t *x, const vec_t *ref, int iters, int thread_count);
+void report_numa(struct sparse_matrix_csr *A, vec_t *x, int iters, int thread_count);
+long long run_single_calls(int mode, struct sparse_matrix_csr *A, struct csr_spmv_plan *plan, vec_t *x, const vec_t *ref, int calls, int thread_count);
+void csr_balanced(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void csr_merge(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void csr_powers(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void csr_plan(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void csr_reordered(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void csr_compact_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void csr_compact_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void bcsr_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void bcsr_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void sell_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void sym_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void sym_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
+void sell_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count);
 
 int main(int argc, char* argv[]) {
-    long long matrix_size;  /* row/columnn size of square matrix */
-    float sparsity;         /* percentage of zero-elements of the matrix */
+    long long matrix_size = 0; /* row/columnn size of square matrix */
+    float sparsity = 0;     /* percentage of zero-elements of the matrix */
     int num_mults;          /* number of repeated multiplications */
     int thread_count;
+    int direct_csr = 0;     /* generate the CSR matrix directly, without the dense matrix */
+    int sell_c = matvecs_sell_default_c();  /* SELL-C-sigma slice height */
+    int sell_sigma = SELL_DEFAULT_SIGMA;    /* SELL-C-sigma sorting window */
+    int powers_steps = POWERS_DEFAULT_STEPS; /* multiplications per round of the matrix-powers kernel */
+    int spmm_k = SPMM_DEFAULT_VECTORS;      /* vectors of the SpMM block */
+    int block_r = 0, block_c = 0;           /* BCSR block size, 0: chosen from the estimated fill ratios */
+    const char *matrix_file = NULL;         /* .mtx or binary CSR file to load instead of generating the matrix */
+    const char *save_file = NULL;           /* binary CSR file to write the matrix to */
+    int numa_place = 0;                     /* re-place the CSR arrays with the row schedule of the multiplication */
+    int pin_threads = 0;                    /* pin the OpenMP threads, spread over the CPUs */
+
+    /* Parse options */
+    int opt;
+    while ((opt = getopt(argc, argv, "dC:s:b:k:m:f:w:nP")) != -1) {
+        switch (opt) {
+            case 'd':
+                direct_csr = 1;
+                break;
+            case 'f':
+                matrix_file = optarg;
+                direct_csr = 1; /* no dense matrix to compare with */
+                break;
+            case 'w':
+                save_file = optarg;
+                break;
+            case 'n':
+                numa_place = 1;
+                break;
+            case 'P':
+                pin_threads = 1;
+                break;
+            case 'C':
+                sell_c = strtol(optarg, NULL, 10);
+                if (sell_c < 1 || sell_c > SELL_MAX_C) Usage(argv[0]);
+                break;
+            case 's':
+                sell_sigma = strtol(optarg, NULL, 10);
+                if (sell_sigma < 1) Usage(argv[0]);
+                break;
+            case 'k':
+                powers_steps = strtol(optarg, NULL, 10);
+                if (powers_steps < 1) Usage(argv[0]);
+                break;
+            case 'm':
+                spmm_k = strtol(optarg, NULL, 10);
+                if (spmm_k < 1) Usage(argv[0]);
+                break;
+            case 'b':
+                if (sscanf(optarg, "%dx%d", &block_r, &block_c) != 2 || block_r < 1 || block_c < 1) Usage(argv[0]);
+                break;
+            default:
+                Usage(argv[0]);
+        }
+    }
 
     /* Parse inputs and error check */
-    if (argc < 5) Usage(argv[0]);
+    /* The size and sparsity come from the file when the matrix is loaded */
+    int nargs = matrix_file ? 2 : 4;
+    if (argc - optind < nargs) Usage(argv[0]);
+    char **args = &argv[optind];
 
-    matrix_size  = strtoll(argv[1], NULL, 10); if (matrix_size  <= 0) Usage(argv[0]);
-    sparsity     =  strtof(argv[2], NULL);     if (sparsity     <  0 || sparsity >= 1) Usage(argv[0]);
-    num_mults    =  strtol(argv[3], NULL, 10); if (num_mults    <  0) Usage(argv[0]);
-    thread_count =  strtol(argv[4], NULL, 10); if (thread_count <= 0) Usage(argv[0]);
+    if (!matrix_file) {
+        matrix_size = strtoll(args[0], NULL, 10); if (matrix_size <= 0) Usage(argv[0]);
+        sparsity    =  strtof(args[1], NULL);     if (sparsity    <  0 || sparsity >= 1) Usage(argv[0]);
+    }
+    num_mults    =  strtol(args[nargs-2], NULL, 10); if (num_mults    <  0) Usage(argv[0]);
+    thread_count =  strtol(args[nargs-1], NULL, 10); if (thread_count <= 0) Usage(argv[0]);
 
     long long rows = matrix_size, cols = matrix_size;
 
-    printf("Square Matrix of dimensions NxN with N=%lld, sparsity=%f\nRepeated multiplications: %d\nThread count: %d\n", matrix_size, sparsity, num_mults, thread_count);
+    if (matrix_file) {
+        printf("Square Matrix from file %s\nRepeated multiplications: %d\nThread count: %d\n", matrix_file, num_mults, thread_count);
+    } else {
+        printf("Square Matrix of dimensions NxN with N=%lld, sparsity=%f\nRepeated multiplications: %d\nThread count: %d\n", matrix_size, sparsity, num_mults, thread_count);
+    }
+    printf("Value type: %s\n", VALUE_TYPE_NAME);
     
+    /* Pinned before anything is allocated, so that first touches happen on the final nodes */
+    if (pin_threads) {
+        printf("Pinned threads: %d\n", numa_pin_threads(thread_count));
+    }
+
     /* Timing variables */
     struct timespec start, end;
     double elapsed_time, gen_time;
@@ -36,20 +154,55 @@ int main(int argc, char* argv[]) {
     struct xorshift32_state prng_state;
     prng_state.a = (unsigned int) time(NULL); /* seed the PRNG */
 
+    struct sparse_matrix_csr *mtx_csr_ptr          = malloc(sizeof(struct sparse_matrix_csr));
+    struct sparse_matrix_csr *mtx_csr_parallel_ptr = malloc(sizeof(struct sparse_matrix_csr));
+    *mtx_csr_ptr = init_csr_matrix();
+    *mtx_csr_parallel_ptr = init_csr_matrix();
+
     printf("\n================================================");
-    /* -------------------- Generate the matrix and the array of integers ---------------------- */
-    printf("\nGenerating the square matrix of integers...\n");
-    int **mtx_p;      /* pointer to the matrix of integers (like an array of int pointers)*/
+    /* -------------------- Generate the matrix and the vector array --------------------------- */
+    value_t **mtx_p = NULL; /* pointer to the matrix (like an array of row pointers) */
     long long nnz;  /* number of non-zero elements generated */
+    struct csr_map mtx_map; /* mapping of a binary CSR file, used by mtx_csr_ptr if mapped */
+    int mapped = 0;
+    if (matrix_file) {
+        printf("\nLoading the sparse matrix from %s...\n", matrix_file);
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+            if (is_csr_file(matrix_file)) {
+                csr_map_open(matrix_file, thread_count, &mtx_map);
+                free(mtx_csr_ptr);
+                mtx_csr_ptr = &mtx_map.csr;
+                mapped = 1;
+            } else {
+                read_mtx_csr(matrix_file, thread_count, mtx_csr_ptr);
+            }
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        gen_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Matrix %s time (s): %9.6f\n", mapped ? "mapping" : "parsing", gen_time);
+        matrix_size = rows = cols = mtx_csr_ptr->rows;
+        nnz = mtx_csr_ptr->row_ptr[rows];
+        sparsity = 1 - (double) nnz / ((double) rows * rows);
+        printf("  Dimensions: %lldx%lld, sparsity=%f\n", rows, cols, sparsity);
+        printf("  NNZ loaded: %lld\n", nnz);
+    } else if (direct_csr) {
+        printf("\nGenerating the sparse matrix directly in CSR...\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+            nnz = gen_sparse_matrix_csr(rows, cols, sparsity, 10, thread_count, &prng_state, mtx_csr_ptr);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        gen_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Direct CSR generation time (s): %9.6f\n", gen_time);
+    } else {
+        printf("\nGenerating the square matrix...\n");
         clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
             mtx_p = gen_sparse_matrix(rows, cols, sparsity, 10, thread_count, &prng_state, &nnz);
         clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
-    gen_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
-    printf("  Matrix generation time (s): %9.6f\n", gen_time);
-    printf("  NNZ generated: %lld\n", nnz);
+        gen_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Matrix generation time (s): %9.6f\n", gen_time);
+    }
+    if (!matrix_file) printf("  NNZ generated: %lld\n", nnz);
 
-    printf("\nGenerating the vector array of integers...\n");
-    int *vec; /* pointer to the vector array of integers */
+    printf("\nGenerating the vector array...\n");
+    vec_t *vec; /* pointer to the vector array */
         clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
             vec = gen_int_array(cols, 10);
         clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
@@ -57,78 +210,137 @@ int main(int argc, char* argv[]) {
     printf("  Vector generation time (s): %9.6f\n", gen_time);
 
     
-    /* ----------------------------- Build CSR Representation ----------------------------- */
-    printf("\n================================================");
-    struct sparse_matrix_csr *mtx_csr_ptr          = malloc(sizeof(struct sparse_matrix_csr));
-    struct sparse_matrix_csr *mtx_csr_parallel_ptr = malloc(sizeof(struct sparse_matrix_csr));
-    *mtx_csr_ptr = init_csr_matrix();
-    *mtx_csr_parallel_ptr = init_csr_matrix();
+    /* The dense matrix only exists if the CSR matrix was not generated directly */
+    vec_t *vec_res          = malloc(rows * sizeof(vec_t));
+    vec_t *vec_res_parallel = malloc(rows * sizeof(vec_t));
+    long long nerrors;
+    if (!direct_csr) {
+        /* ----------------------------- Build CSR Representation ----------------------------- */
+        printf("\n================================================");
 
-    /* Serial CSR Build */ 
-    printf("\nSerial CSR build...\n");
-    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
-    build_csr_matrix(mtx_p, mtx_csr_ptr, rows, cols, nnz);
-    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
-    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; 
-    printf("  Serial CSR build time (s):   %9.6f\n", elapsed_time);
-
-    /* Parallel CSR Build */ 
-    printf("\nParallel CSR build...\n");
-    clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
-    build_csr_matrix_parallel(mtx_p, mtx_csr_parallel_ptr, rows, cols, nnz, (size_t) thread_count);
-    clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
-    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; 
-    printf("  Parallel CSR build time (s): %9.6f\n", elapsed_time);
-
-    /* Confirm CSR building correctness */
-    printf("\nComparing Serial & Parallel CSR builds...\n");
-    int correct_build = compare_csr_matrix(mtx_csr_ptr, mtx_csr_parallel_ptr, nnz);
-
-    if (correct_build) {
-        printf("  CSR builds match!\n");
-    } else {
-        printf("  ERROR: CSR builds don't match!\n");
-    }
+        /* Serial CSR Build */ 
+        printf("\nSerial CSR build...\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        build_csr_matrix(mtx_p, mtx_csr_ptr, rows, cols, nnz);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; 
+        printf("  Serial CSR build time (s):   %9.6f\n", elapsed_time);
 
-    // print_csr_matrix(mtx_csr_ptr, nnz);
-    // print_csr_matrix(mtx_csr_parallel_ptr, nnz);
+        /* Parallel CSR Build */ 
+        printf("\nParallel CSR build...\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        build_csr_matrix_parallel(mtx_p, mtx_csr_parallel_ptr, rows, cols, nnz, (size_t) thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; 
+        printf("  Parallel CSR build time (s): %9.6f\n", elapsed_time);
 
+        /* Confirm CSR building correctness */
+        printf("\nComparing Serial & Parallel CSR builds...\n");
+        int correct_build = compare_csr_matrix(mtx_csr_ptr, mtx_csr_parallel_ptr, nnz);
 
-    /* -------------------- Dense matrix repeated multiplication ---------------------- */
-    printf("\n================================================");
-    int *vec_res          = malloc(rows * sizeof(int));
-    int *vec_res_parallel = malloc(rows * sizeof(int));
-    printf("\nDense matrix repeated multiplication SERIAL...\n");
+        if (correct_build) {
+            printf("  CSR builds match!\n");
+        } else {
+            printf("  ERROR: CSR builds don't match!\n");
+        }
+
+        /* Two-pass parallel CSR Build: counts, scan, then direct writes */
+        printf("\nTwo-pass CSR build...\n");
+        struct sparse_matrix_csr *mtx_csr_two_pass_ptr = malloc(sizeof(struct sparse_matrix_csr));
+        *mtx_csr_two_pass_ptr = init_csr_matrix();
         clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
-            matvecs(mtx_p, vec, vec_res, matrix_size, num_mults);
+        build_csr_matrix_two_pass(mtx_p, mtx_csr_two_pass_ptr, rows, cols, (size_t) thread_count);
         clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
-    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
-    printf("  Dense matrix %dx mult Serial time (s):   %9.6f\n", num_mults, elapsed_time);
-    // print_matrix(mtx_p, rows, cols);
-    // print_vector(vec, rows);
-    // print_vector(vec_res, rows);
-    printf("\nDense matrix repeated multiplication PARALLEL...\n");
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; 
+        printf("  Two-pass CSR build time (s): %9.6f\n", elapsed_time);
+
+        if (mtx_csr_two_pass_ptr->row_ptr[rows] == nnz && compare_csr_matrix(mtx_csr_ptr, mtx_csr_two_pass_ptr, nnz)) {
+            printf("  CSR builds match!\n");
+        } else {
+            printf("  ERROR: CSR builds don't match!\n");
+        }
+        free_csr_matrix(mtx_csr_two_pass_ptr);
+
+        // print_csr_matrix(mtx_csr_ptr, nnz);
+        // print_csr_matrix(mtx_csr_parallel_ptr, nnz);
+
+
+        /* -------------------- Dense matrix repeated multiplication ---------------------- */
+        printf("\n================================================");
+        printf("\nDense matrix repeated multiplication SERIAL...\n");
+            clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+                matvecs(mtx_p, vec, vec_res, matrix_size, num_mults);
+            clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Dense matrix %dx mult Serial time (s):   %9.6f\n", num_mults, elapsed_time);
+        // print_matrix(mtx_p, rows, cols);
+        // print_vector(vec, rows);
+        // print_vector(vec_res, rows);
+        printf("\nDense matrix repeated multiplication PARALLEL...\n");
+            clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+                matvecs_parallel(mtx_p, vec, vec_res_parallel, matrix_size, num_mults, thread_count);
+            clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Dense matrix %dx mult Parallel time (s): %9.6f\n", num_mults, elapsed_time);
+        // print_vector(vec_res_parallel, rows);
+
+        printf("\nDense matrix repeated multiplication SIMD (%s kernel, contiguous rows)...\n", matvecs_dense_isa());
+        vec_t *vec_res_dense = malloc(rows * sizeof(vec_t));
+            clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+                matvecs_dense(mtx_p[0], vec, vec_res_dense, matrix_size, num_mults, thread_count);
+            clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Dense matrix %dx mult SIMD time (s): %9.6f\n", num_mults, elapsed_time);
+        nerrors = vectors_diffs(vec_res, vec_res_dense, matrix_size);
+        if (nerrors == 0) {
+            printf("  Results match!\n");
+        } else {
+            printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
+        }
+        free(vec_res_dense);
+
+        /* Compare the two resulting vectors */
+        printf("\nComparing Serial & Parallel results...\n");
+        nerrors = vectors_diffs(vec_res, vec_res_parallel, matrix_size);
+        if (nerrors == 0) {
+            printf("  Results match!\n");
+        } else {
+            printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
+        }
+    }
+
+
+    if (numa_place) {
+        printf("\nNUMA first-touch placement of the CSR arrays...\n");
+        if (mapped) {
+            printf("  Skipped: the arrays are mapped from the file\n");
+        } else {
+            clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+                int placed = csr_first_touch(mtx_csr_ptr, thread_count);
+            clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+            elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+            if (placed) {
+                printf("  First-touch placement time (s): %9.6f\n", elapsed_time);
+            } else {
+                printf("  ERROR: not enough memory to copy the arrays\n");
+            }
+        }
+    }
+
+    if (save_file) {
+        printf("\nWriting the binary CSR file %s...\n", save_file);
         clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
-            matvecs_parallel(mtx_p, vec, vec_res_parallel, matrix_size, num_mults, thread_count);
+            write_csr_file(save_file, mtx_csr_ptr);
         clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
-    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
-    printf("  Dense matrix %dx mult Parallel time (s): %9.6f\n", num_mults, elapsed_time);
-    // print_vector(vec_res_parallel, rows);
-
-    /* Compare the two resulting vectors */
-    printf("\nComparing Serial & Parallel results...\n");
-    long long nerrors = vectors_diffs(vec_res, vec_res_parallel, matrix_size);
-    if (nerrors == 0) {
-        printf("  Results match!\n");
-    } else {
-        printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Binary CSR write time (s): %9.6f\n", elapsed_time);
     }
 
 
     /* -------------------- Sparse matrix repeated multiplication ---------------------- */
     printf("\n================================================");
-    int *vec_res_sparse          = malloc(rows * sizeof(int));
-    int *vec_res_sparse_parallel = malloc(rows * sizeof(int));
+    vec_t *vec_res_sparse          = malloc(rows * sizeof(vec_t));
+    vec_t *vec_res_sparse_parallel = malloc(rows * sizeof(vec_t));
     printf("\nSparse matrix repeated multiplication SERIAL...\n");
         clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
             matvecs_csr(mtx_csr_ptr, vec, vec_res_sparse, num_mults);
@@ -155,27 +367,244 @@ int main(int argc, char* argv[]) {
         printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
     }
 
-    
-    /* ------------------------------- Compare Dense vs CSR ---------------------------- */
+    report_numa(mtx_csr_ptr, vec, num_mults, thread_count);
+
+    /* Parallel variants with other work partitions, checked against the serial result */
+    run_variant("Balanced",   csr_balanced, mtx_csr_ptr, rows, vec, vec_res_sparse, num_mults, thread_count);
+    run_variant("Merge-path", csr_merge,    mtx_csr_ptr, rows, vec, vec_res_sparse, num_mults, thread_count);
+
+    /* Persistent plan: partition and work vectors set up once, outside of the timed multiplications */
+    printf("\nSpMV plan...\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        struct csr_spmv_plan *spmv_plan = csr_spmv_plan_create(mtx_csr_ptr, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+    printf("  SpMV plan time (s): %9.6f\n", elapsed_time);
+    run_variant("Plan", csr_plan, spmv_plan, rows, vec, vec_res_sparse, num_mults, thread_count);
+
+    /* Solver-like use: one call per multiplication, where the setup of every call matters */
+    printf("\nSparse matrix %d calls of 1 multiplication...\n", num_mults);
+    run_single_calls(0, mtx_csr_ptr, spmv_plan, vec, vec_res_sparse, num_mults, thread_count);
+    run_single_calls(1, mtx_csr_ptr, spmv_plan, vec, vec_res_sparse, num_mults, thread_count);
+    run_single_calls(2, mtx_csr_ptr, spmv_plan, vec, vec_res_sparse, num_mults, thread_count);
+    free_csr_spmv_plan(spmv_plan);
+
+    /* Matrix powers: the plan is built outside of the timed multiplication */
+    printf("\nMatrix-powers plan (up to %d steps)...\n", powers_steps);
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        struct csr_powers_plan *powers = csr_powers_plan_create(mtx_csr_ptr, powers_steps, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+    printf("  Matrix-powers plan time (s): %9.6f\n", elapsed_time);
+    if (powers->s > 1) {
+        printf("  Steps per round: %d, blocks: %lld, redundant work: %.1f%%\n", powers->s, powers->nblocks,
+               mtx_csr_ptr->row_ptr[rows] > 0 ? 100.0 * ((double) powers->work / ((double) powers->s * mtx_csr_ptr->row_ptr[rows]) - 1) : 0.0);
+    } else {
+        printf("  Too many ghost rows for any fusion: plain parallel multiplication\n");
+    }
+    struct powers_variant powers_args = { mtx_csr_ptr, powers };
+    run_variant("Matrix-powers", csr_powers, &powers_args, rows, vec, vec_res_sparse, num_mults, thread_count);
+    free_csr_powers_plan(powers);
+
+    /* Reverse Cuthill-McKee reordering (the generated matrices are unsymmetric), timed separately from the multiplication it is amortized over */
+    printf("\nRCM reordering...\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        struct csr_reordered mtx_rcm = csr_permute(mtx_csr_ptr, csr_rcm_permutation(mtx_csr_ptr, 0), thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+    printf("  RCM reordering time (s): %9.6f\n", elapsed_time);
+    printf("  Bandwidth: %lld before, %lld after\n", csr_bandwidth(mtx_csr_ptr), csr_bandwidth(mtx_rcm.mtx));
+    run_variant("RCM", csr_reordered, &mtx_rcm, rows, vec, vec_res_sparse, num_mults, thread_count);
+    free_csr_reordered(&mtx_rcm);
+
+
+    /* ---------------------- SpMM: block of vectors multiplied together ---------------------- */
     printf("\n================================================");
-    printf("\nFINAL: Comparing Dense vs Sparse matrix (parallel) multiplication results...\n");
-    nerrors = vectors_diffs(vec_res_parallel, vec_res_sparse_parallel, matrix_size);
+    printf("\nSpMM with %d vectors (%s kernel)...\n", spmm_k, spmm_csr_isa());
+    vec_t *vecs     = gen_int_array(rows * spmm_k, 10); /* interleaved: vecs[i*spmm_k + l] is entry i of vector l */
+    vec_t *vecs_res = malloc(rows * spmm_k * sizeof(vec_t));
+    vec_t *vecs_ref = malloc(rows * spmm_k * sizeof(vec_t));
+    vec_t *col_in   = malloc(rows * sizeof(vec_t));
+    vec_t *col_out  = malloc(rows * sizeof(vec_t));
+
+    /* Reference: one vector at a time */
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        for (int l = 0; l < spmm_k; l++) {
+            for (long long i = 0; i < rows; i++) col_in[i] = vecs[i * spmm_k + l];
+            matvecs_csr_parallel(mtx_csr_ptr, col_in, col_out, num_mults, thread_count);
+            for (long long i = 0; i < rows; i++) vecs_ref[i * spmm_k + l] = col_out[i];
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+    printf("  Sparse matrix %dx mult %d vectors one by one time (s): %9.6f\n", num_mults, spmm_k, elapsed_time);
+
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        matmuls_csr_parallel(mtx_csr_ptr, vecs, vecs_res, spmm_k, num_mults, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+    printf("  Sparse matrix %dx mult %d vectors SpMM time (s):       %9.6f\n", num_mults, spmm_k, elapsed_time);
+
+    nerrors = vectors_diffs(vecs_ref, vecs_res, rows * spmm_k);
     if (nerrors == 0) {
         printf("  Results match!\n");
     } else {
         printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
     }
+    free(vecs);
+    free(vecs_res);
+    free(vecs_ref);
+    free(col_in);
+    free(col_out);
+
+
+    /* ------------------------ Compact CSR (smaller column indices) ------------------------ */
+    const enum csr_compact_encoding encodings[2] = { CSR_COMPACT_U32, CSR_COMPACT_DELTA };
+    const char *encoding_names[2][3] = { { "u32", "Compact u32 serial", "Compact u32 parallel" },
+                                         { "delta", "Compact delta serial", "Compact delta parallel" } };
+    for (int e = 0; e < 2; e++) {
+        printf("\n================================================");
+        printf("\nCompact CSR build (%s column indices)...\n", encoding_names[e][0]);
+        struct sparse_matrix_csr_compact mtx_compact;
+            clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+            int compact_ok = build_csr_compact_matrix(mtx_csr_ptr, &mtx_compact, encodings[e], thread_count);
+            clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        if (!compact_ok) {
+            printf("  ERROR: matrix not representable with %s column indices\n", encoding_names[e][0]);
+            continue;
+        }
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Compact CSR build time (s): %9.6f\n", elapsed_time);
+        long long nnz_csr = mtx_csr_ptr->row_ptr[rows];
+        if (nnz_csr > 0) {
+            printf("  Bytes per non-zero (value + index): %.2f, CSR: %.2f\n",
+                   sizeof(value_t) + (double) csr_compact_index_bytes(&mtx_compact) / nnz_csr, (double) (sizeof(value_t) + sizeof(long long)));
+        }
+
+        run_variant(encoding_names[e][1], csr_compact_serial,   &mtx_compact, rows, vec, vec_res_sparse, num_mults, thread_count);
+        run_variant(encoding_names[e][2], csr_compact_parallel, &mtx_compact, rows, vec, vec_res_sparse, num_mults, thread_count);
+        free_csr_compact_matrix(&mtx_compact);
+    }
+
+
+    /* ----------------------------------- Block CSR ----------------------------------- */
+    printf("\n================================================");
+    if (block_r == 0) {
+        printf("\nBCSR block size selection...\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+            double fill = bcsr_choose_block(mtx_csr_ptr, &block_r, &block_c, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Chosen block: %dx%d, estimated fill ratio %.2f\n", block_r, block_c, fill);
+        printf("  Block selection time (s): %9.6f\n", elapsed_time);
+    }
+    printf("\nBCSR %dx%d build (%s kernel)...\n", block_r, block_c, matvecs_bcsr_unrolled(block_r, block_c) ? "unrolled" : "generic");
+    struct sparse_matrix_bcsr mtx_bcsr;
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        int bcsr_ok = build_bcsr_matrix(mtx_csr_ptr, &mtx_bcsr, block_r, block_c, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    if (bcsr_ok) {
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  BCSR build time (s): %9.6f\n", elapsed_time);
+        printf("  Blocks: %lld, fill ratio %.2f\n", mtx_bcsr.nblocks,
+               mtx_bcsr.nnz > 0 ? (double) mtx_bcsr.nblocks * block_r * block_c / mtx_bcsr.nnz : 1.0);
+
+        run_variant("BCSR serial",   bcsr_serial,   &mtx_bcsr, rows, vec, vec_res_sparse, num_mults, thread_count);
+        run_variant("BCSR parallel", bcsr_parallel, &mtx_bcsr, rows, vec, vec_res_sparse, num_mults, thread_count);
+        free_bcsr_matrix(&mtx_bcsr);
+    } else {
+        printf("  ERROR: matrix too large for the int block columns of BCSR\n");
+    }
+
+
+    /* ----------------------------- SELL-C-sigma multiplication ----------------------------- */
+    printf("\n================================================");
+    printf("\nSELL-%d-%d build (%s kernel)...\n", sell_c, sell_sigma, matvecs_sell_isa(sell_c));
+    struct sparse_matrix_sell mtx_sell = init_sell_matrix();
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        int sell_ok = build_sell_matrix(mtx_csr_ptr, &mtx_sell, sell_c, sell_sigma, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    if (sell_ok) {
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  SELL build time (s): %9.6f\n", elapsed_time);
+        long long stored = mtx_sell.slice_ptr[mtx_sell.nslices];
+        printf("  Stored elements: %lld (%.1f%% padding)\n", stored, stored > 0 ? 100.0 * (stored - mtx_sell.nnz) / stored : 0.0);
+
+        run_variant("SELL serial",   sell_serial,   &mtx_sell, rows, vec, vec_res_sparse, num_mults, thread_count);
+        run_variant("SELL parallel", sell_parallel, &mtx_sell, rows, vec, vec_res_sparse, num_mults, thread_count);
+    } else {
+        printf("  ERROR: matrix too large for the 32-bit column indices of SELL-C-sigma\n");
+    }
+
+
+
+    /* ------------------------- Symmetric CSR (upper triangle only) ------------------------- */
+    printf("\n================================================");
+    printf("\nSymmetric CSR build...\n");
+    struct sparse_matrix_csr_sym mtx_sym;
+    const vec_t *sym_ref = vec_res_sparse;    /* reference result: the one of the full matrix */
+    vec_t *vec_res_sym_full = NULL;
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        int sym_input = build_csr_sym_matrix(mtx_csr_ptr, &mtx_sym, 1, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    if (!sym_input) {
+        /* Generated matrices are not symmetric: the symmetric matrix of the upper triangle is used, with its full CSR as reference */
+        printf("  Matrix not symmetric: using the symmetric matrix of its upper triangle\n");
+        clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+        build_csr_sym_matrix(mtx_csr_ptr, &mtx_sym, 0, thread_count);
+        clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+    }
+    elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+    printf("  Symmetric CSR build time (s): %9.6f\n", elapsed_time);
+    printf("  Stored elements: %lld of %lld non-zeros\n", mtx_sym.row_ptr[rows], mtx_sym.nnz);
+    if (!sym_input) {
+        struct sparse_matrix_csr *mtx_sym_full_ptr = malloc(sizeof(struct sparse_matrix_csr));
+        *mtx_sym_full_ptr = init_csr_matrix();
+        expand_csr_sym_matrix(&mtx_sym, mtx_sym_full_ptr);
+        vec_res_sym_full = malloc(rows * sizeof(vec_t));
+        printf("\nSparse matrix repeated multiplication Symmetric full CSR...\n");
+            clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+                matvecs_csr_parallel(mtx_sym_full_ptr, vec, vec_res_sym_full, num_mults, thread_count);
+            clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+        elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+        printf("  Sparse matrix %dx mult Symmetric full CSR time (s): %9.6f\n", num_mults, elapsed_time);
+        free_csr_matrix(mtx_sym_full_ptr);
+        sym_ref = vec_res_sym_full;
+    }
+    run_variant("Symmetric serial",   sym_serial,   &mtx_sym, rows, vec, sym_ref, num_mults, thread_count);
+    run_variant("Symmetric parallel", sym_parallel, &mtx_sym, rows, vec, sym_ref, num_mults, thread_count);
+    free_csr_sym_matrix(&mtx_sym);
+    free(vec_res_sym_full);
+
+    
+    /* ------------------------------- Compare Dense vs CSR ---------------------------- */
+    if (!direct_csr) {
+        printf("\n================================================");
+        printf("\nFINAL: Comparing Dense vs Sparse matrix (parallel) multiplication results...\n");
+        nerrors = vectors_diffs(vec_res_parallel, vec_res_sparse_parallel, matrix_size);
+        if (nerrors == 0) {
+            printf("  Results match!\n");
+        } else {
+            printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
+        }
+    }
 
 
     /* ------------------------------------ Cleanup ------------------------------------ */
     /* Free allocated memory */
-    free(mtx_p[0]); // frees the contiguous data block
-    free(mtx_p);
+    if (mtx_p) {
+        free(mtx_p[0]); // frees the contiguous data block
+        free(mtx_p);
+    }
     free(vec);
     free(vec_res);
     free(vec_res_parallel);
-    free_csr_matrix(mtx_csr_ptr);
+    if (mapped) {
+        csr_map_close(&mtx_map);
+    } else {
+        free_csr_matrix(mtx_csr_ptr);
+    }
     free_csr_matrix(mtx_csr_parallel_ptr);
+    free_sell_matrix(&mtx_sell);
 
     return 0;
 } /* main */
@@ -186,10 +615,230 @@ int main(int argc, char* argv[]) {
  *            and terminate.
  */
 void Usage(char *prog_name) {
-   fprintf(stderr, "Usage: %s <matrix_size> <sparsity> <num_mults> <thread_count>\n", prog_name);
+   fprintf(stderr, "Usage: %s [-d] [-n] [-P] [-w file] [-C slice_height] [-s sigma] [-b RxC] [-k steps] [-m vectors] <matrix_size> <sparsity> <num_mults> <thread_count>\n", prog_name);
+   fprintf(stderr, "       %s -f file [-w file] [options] <num_mults> <thread_count>\n", prog_name);
+   fprintf(stderr, "   -d: generate the matrix directly in CSR (no dense matrix, dense multiplication and CSR builds skipped).\n");
+   fprintf(stderr, "   -f: load the matrix from a Matrix Market (.mtx) file, or map a binary CSR file written by -w (implies -d).\n");
+   fprintf(stderr, "   -n: re-place the CSR arrays so that each thread first touches the rows it multiplies (NUMA).\n");
+   fprintf(stderr, "   -P: pin the threads, spread over the allowed CPUs.\n");
+   fprintf(stderr, "   -w: write the CSR matrix to a binary CSR file, loadable without parsing by -f.\n");
+   fprintf(stderr, "   -C: slice height of the SELL-C-sigma format, 1 to %d (default: vector width of the CPU, %d).\n", SELL_MAX_C, matvecs_sell_default_c());
+   fprintf(stderr, "   -s: sorting window of the SELL-C-sigma format, in rows (default: %d).\n", SELL_DEFAULT_SIGMA);
+   fprintf(stderr, "   -k: multiplications fused by the matrix-powers kernel (default: %d).\n", POWERS_DEFAULT_STEPS);
+   fprintf(stderr, "   -m: number of vectors multiplied together by SpMM (default: %d).\n", SPMM_DEFAULT_VECTORS);
+   fprintf(stderr, "   -b: block size of the BCSR format, as RxC (default: chosen from the estimated fill ratios).\n");
    fprintf(stderr, "   matrix_size: Row/column size (square matrix). Should be positive.\n");
    fprintf(stderr, "   sparsity: Percentage of zero-elements. Should be a float from 0 to 1.\n");
    fprintf(stderr, "   num_mults: Number of repeated multiplications. Should be non-negative.\n");
    fprintf(stderr, "   thread_count: Number of threads. Should be positive.\n");
    exit(0);
-}  /* Usage */
\ No newline at end of file
+}  /* Usage */
+
+/*--------------------------------------------------------------------
+ * Function:  run_variant
+ * Purpose:   Time one variant of the repeated sparse multiplication
+ *            of the matrix A (ROWS rows, in the variant's format),
+ *            print it under NAME, and compare its result with REF.
+ *            Returns the number of mismatches.
+ */
+long long run_variant(const char *name, matvecs_fn fn, void *A, long long rows, vec_t *x, const vec_t *ref, int iters, int thread_count) {
+   struct timespec start, end;
+   vec_t *res = malloc(rows * sizeof(vec_t));
+   if (!res) {
+      perror("malloc res");
+      exit(EXIT_FAILURE);
+   }
+
+   printf("\nSparse matrix repeated multiplication %s...\n", name);
+   clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+   fn(A, x, res, iters, thread_count);
+   clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+   double elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+   printf("  Sparse matrix %dx mult %s time (s): %9.6f\n", iters, name, elapsed_time);
+
+   long long nerrors = vectors_diffs(ref, res, rows);
+   if (nerrors == 0) {
+      printf("  Results match!\n");
+   } else {
+      printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
+   }
+
+   free(res);
+   return nerrors;
+}  /* run_variant */
+
+/*--------------------------------------------------------------------
+ * Function:  report_numa
+ * Purpose:   Print the NUMA node of each thread and of the pages of
+ *            the CSR arrays, then time matvecs_csr_parallel and print
+ *            the bandwidth of the threads of each node (bytes of the
+ *            rows of its static schedule, csr_spmv_bytes).
+ */
+void report_numa(struct sparse_matrix_csr *A, vec_t *x, int iters, int thread_count) {
+   struct timespec start, end;
+   long long rows = A->rows, nnz = A->row_ptr[rows];
+   int *node = malloc(thread_count * sizeof(int));
+   vec_t *res = malloc(rows * sizeof(vec_t));
+   if (!node || !res) {
+      perror("malloc report_numa");
+      exit(EXIT_FAILURE);
+   }
+
+   printf("\nNUMA placement and bandwidth per node...\n");
+   int nnodes = numa_thread_nodes(thread_count, node);
+   long long pages[NUMA_MAX_NODES] = {0};
+   long long found = numa_page_nodes(A->values, nnz * sizeof(value_t), pages);
+   if (found >= 0) found += numa_page_nodes(A->col_index, nnz * sizeof(long long), pages);
+   if (found >= 0) found += numa_page_nodes(A->row_ptr, (rows + 1) * sizeof(long long), pages);
+   for (int n = 0; n < NUMA_MAX_NODES; n++) {
+      if (pages[n] > 0 && n + 1 > nnodes) nnodes = n + 1;
+   }
+   if (found > 0) {
+      for (int n = 0; n < nnodes; n++)
+         printf("  Node %d: %5.1f%% of the matrix pages\n", n, 100.0 * pages[n] / found);
+   } else {
+      printf("  Page placement unknown\n");
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+   matvecs_csr_parallel(A, x, res, iters, thread_count);
+   clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+   double elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+
+   /* Rows of thread t under schedule(static): contiguous blocks, the first rows % thread_count one row longer */
+   double bytes[NUMA_MAX_NODES] = {0};
+   int threads[NUMA_MAX_NODES] = {0};
+   for (int t = 0; t < thread_count; t++) {
+      long long chunk = rows / thread_count, rem = rows % thread_count;
+      long long lo = t * chunk + (t < rem ? t : rem);
+      long long hi = lo + chunk + (t < rem ? 1 : 0);
+      int n = node[t] >= 0 ? node[t] : 0;
+      bytes[n] += csr_spmv_bytes(A, lo, hi) * iters;
+      threads[n]++;
+   }
+   for (int n = 0; n < (nnodes > 0 ? nnodes : 1); n++) {
+      if (threads[n] == 0) continue;
+      printf("  Node %d: %d threads, %.2f GB/s\n", n, threads[n], elapsed_time > 0 ? bytes[n] / elapsed_time / 1e9 : 0.0);
+   }
+
+   free(node);
+   free(res);
+}  /* report_numa */
+
+/*--------------------------------------------------------------------
+ * Function:  run_single_calls
+ * Purpose:   Time CALLS multiplications of A done one call at a time,
+ *            as a solver loop does, and compare the result with REF.
+ *            MODE 0: matvecs_csr_parallel, 1: csr_spmv_execute with
+ *            PLAN, 2: csr_spmv_execute_team with PLAN, the whole loop
+ *            running in one parallel region.
+ *            Returns the number of mismatches.
+ */
+long long run_single_calls(int mode, struct sparse_matrix_csr *A, struct csr_spmv_plan *plan, vec_t *x, const vec_t *ref, int calls, int thread_count) {
+   static const char *names[3] = { "matvecs_csr_parallel", "plan", "plan in one team" };
+   struct timespec start, end;
+   long long rows = A->rows;
+   vec_t *buf = malloc(2 * rows * sizeof(vec_t));
+   if (!buf) {
+      perror("malloc buf");
+      exit(EXIT_FAILURE);
+   }
+   vec_t *in = buf, *out = &buf[rows];
+   for (long long i = 0; i < rows; i++) in[i] = x[i];
+
+   clock_gettime(CLOCK_MONOTONIC, &start); /* start time */
+   if (mode == 2) {
+      # pragma omp parallel num_threads(thread_count) firstprivate(in, out)
+      for (int c = 0; c < calls; c++) {
+         csr_spmv_execute_team(plan, in, out, 1);
+         vec_t *t = in; in = out; out = t;
+      }
+      if (calls % 2) { vec_t *t = in; in = out; out = t; } /* same swaps as the threads */
+   } else {
+      for (int c = 0; c < calls; c++) {
+         if (mode == 0) matvecs_csr_parallel(A, in, out, 1, thread_count);
+         else           csr_spmv_execute(plan, in, out, 1);
+         vec_t *t = in; in = out; out = t;
+      }
+   }
+   clock_gettime(CLOCK_MONOTONIC, &end); /* end time */
+   double elapsed_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9; /* elapsed time */
+   printf("  %d calls, %s time (s): %9.6f\n", calls, names[mode], elapsed_time);
+
+   long long nerrors = vectors_diffs(ref, in, rows);
+   if (nerrors == 0) {
+      printf("  Results match!\n");
+   } else {
+      printf("  ERROR: Results mismatch! # of errors = %lld\n", nerrors);
+   }
+
+   free(buf);
+   return nerrors;
+}  /* run_single_calls */
+
+/*--------------------------------------------------------------------
+ * Functions: csr_balanced, csr_plan, csr_merge, csr_powers, csr_reordered,
+ *            csr_compact_serial, csr_compact_parallel, bcsr_serial,
+ *            bcsr_parallel, sell_serial, sell_parallel, sym_serial,
+ *            sym_parallel
+ * Purpose:   Adapt the multiplication variants to the matvecs_fn
+ *            signature of run_variant.
+ */
+void csr_balanced(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   matvecs_csr_balanced(A, x, res, iters, thread_count);
+}
+
+void csr_merge(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   matvecs_csr_merge(A, x, res, iters, thread_count);
+}
+
+void csr_reordered(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   matvecs_csr_reordered(A, x, res, iters, thread_count);
+}
+
+void csr_plan(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   (void) thread_count; /* the plan's */
+   csr_spmv_execute(A, x, res, iters);
+}
+
+/* A is a powers_variant: the matrix and its plan */
+void csr_powers(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   struct powers_variant *v = A;
+   matvecs_csr_powers(v->A, v->plan, x, res, iters, thread_count);
+}
+
+void csr_compact_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   (void) thread_count;
+   matvecs_csr_compact(A, x, res, iters);
+}
+
+void csr_compact_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   matvecs_csr_compact_parallel(A, x, res, iters, thread_count);
+}
+
+void bcsr_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   (void) thread_count;
+   matvecs_bcsr(A, x, res, iters);
+}
+
+void bcsr_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   matvecs_bcsr_parallel(A, x, res, iters, thread_count);
+}
+
+void sell_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   (void) thread_count;
+   matvecs_sell(A, x, res, iters);
+}
+
+void sell_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   matvecs_sell_parallel(A, x, res, iters, thread_count);
+}
+
+void sym_serial(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   (void) thread_count;
+   matvecs_csr_sym(A, x, res, iters);
+}
+
+void sym_parallel(void *A, vec_t *x, vec_t *res, int iters, int thread_count) {
+   matvecs_csr_sym_parallel(A, x, res, iters, thread_count);
+}
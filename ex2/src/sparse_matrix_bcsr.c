@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sparse_matrix_bcsr.h"
+
+/* Fraction of the block rows sampled by bcsr_choose_block, and the least number of block rows sampled */
+#define BCSR_SAMPLE_FRACTION 0.02
+#define BCSR_MIN_SAMPLES 256
+
+struct sparse_matrix_bcsr init_bcsr_matrix(void) {
+    struct sparse_matrix_bcsr m = {
+        .rows       = 0,
+        .r          = 0,
+        .c          = 0,
+        .brows      = 0,
+        .nblocks    = 0,
+        .nnz        = 0,
+        .brow_ptr   = NULL,
+        .bcol       = NULL,
+        .values     = NULL
+    };
+    return m;
+}
+
+static void *xmalloc(size_t size, const char *what) {
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* Number of distinct block columns of block row B. MARK[bc] == B flags the block columns seen so far:
+ * stamping with the block row number avoids clearing MARK between block rows. If LIST is not NULL, the
+ * block columns are appended to it in order of appearance. */
+static long long count_brow_blocks(const struct sparse_matrix_csr *csr, long long b, int r, int c, long long *mark, int *list) {
+    long long row_end = (b + 1) * r < csr->rows ? (b + 1) * r : csr->rows;
+    long long count = 0;
+    for (long long i = b * r; i < row_end; i++) {
+        for (long long j = csr->row_ptr[i]; j < csr->row_ptr[i+1]; j++) {
+            long long bc = csr->col_index[j] / c;
+            if (mark[bc] != b) {
+                mark[bc] = b;
+                if (list) list[count] = (int) bc;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static long long *new_marks(long long bcols) {
+    long long *mark = xmalloc(bcols * sizeof(long long), "malloc block marks");
+    for (long long k = 0; k < bcols; k++) {
+        mark[k] = -1;
+    }
+    return mark;
+}
+
+static int cmp_int(const void *a, const void *b) {
+    int x = *(const int *) a, y = *(const int *) b;
+    return (x > y) - (x < y);
+}
+
+int build_bcsr_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_bcsr *output_mtx_bcsr, int r, int c, int thread_count) {
+    struct sparse_matrix_bcsr *bm = output_mtx_bcsr;
+    long long rows = mtx_csr->rows;
+    long long cols = rows; /* cols = rows for square matrix */
+    if (r < 1 || c < 1) return 0;
+    long long brows = (rows + r - 1) / r;
+    long long bcols = (cols + c - 1) / c;
+    if (bcols > INT_MAX) return 0;
+    if (thread_count < 1) thread_count = 1;
+
+    *bm = init_bcsr_matrix();
+    bm->rows = rows;
+    bm->r = r;
+    bm->c = c;
+    bm->brows = brows;
+    bm->nnz = mtx_csr->row_ptr[rows];
+    bm->brow_ptr = xmalloc((brows + 1) * sizeof(long long), "malloc brow_ptr");
+    long long bsize = (long long) r * c;
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        long long *mark = new_marks(bcols);
+
+        /* Pass 1: blocks of every block row (in brow_ptr[b+1], turned into offsets below) */
+        # pragma omp for schedule(dynamic, 256)
+        for (long long b = 0; b < brows; b++) {
+            bm->brow_ptr[b+1] = count_brow_blocks(mtx_csr, b, r, c, mark, NULL);
+        } /* implicit barrier */
+
+        # pragma omp single
+        {
+            bm->brow_ptr[0] = 0;
+            for (long long b = 0; b < brows; b++) {
+                bm->brow_ptr[b+1] += bm->brow_ptr[b];
+            }
+            bm->nblocks = bm->brow_ptr[brows];
+            bm->bcol   = xmalloc(bm->nblocks * sizeof(int), "malloc bcol");
+            bm->values = xmalloc(bm->nblocks * bsize * sizeof(value_t), "malloc bcsr values");
+        } /* implicit barrier */
+
+        /* Pass 2: sorted block columns of every block row, then its values. POS maps a block column to its block. */
+        int *pos = xmalloc(bcols * sizeof(int), "malloc block positions");
+        for (long long k = 0; k < bcols; k++) {
+            mark[k] = -1;
+        }
+        # pragma omp for schedule(dynamic, 256)
+        for (long long b = 0; b < brows; b++) {
+            long long start = bm->brow_ptr[b];
+            int *list = &bm->bcol[start];
+            long long count = count_brow_blocks(mtx_csr, b, r, c, mark, list);
+            qsort(list, count, sizeof(int), cmp_int);
+            for (long long k = 0; k < count; k++) {
+                pos[list[k]] = (int) k;
+            }
+
+            value_t *v = &bm->values[start * bsize];
+            memset(v, 0, count * bsize * sizeof(value_t));
+            long long row_end = (b + 1) * r < rows ? (b + 1) * r : rows;
+            for (long long i = b * r; i < row_end; i++) {
+                for (long long j = mtx_csr->row_ptr[i]; j < mtx_csr->row_ptr[i+1]; j++) {
+                    long long col = mtx_csr->col_index[j];
+                    v[pos[col / c] * bsize + (i - b * r) * c + col % c] = mtx_csr->values[j];
+                }
+            }
+        }
+
+        free(pos);
+        free(mark);
+    }
+
+    return 1;
+}
+
+double bcsr_estimate_fill(struct sparse_matrix_csr *mtx_csr, int r, int c, double fraction, int thread_count) {
+    long long rows = mtx_csr->rows;
+    long long brows = (rows + r - 1) / r;
+    long long bcols = (rows + c - 1) / c;
+    if (thread_count < 1) thread_count = 1;
+
+    /* Every step-th block row, at least BCSR_MIN_SAMPLES of them when possible */
+    long long step = fraction >= 1 ? 1 : (long long) (1 / fraction);
+    if (step > 1 && brows / step < BCSR_MIN_SAMPLES) step = brows / BCSR_MIN_SAMPLES;
+    if (step < 1) step = 1;
+
+    long long blocks = 0, nnz = 0;
+    # pragma omp parallel num_threads(thread_count) reduction(+:blocks, nnz)
+    {
+        long long *mark = new_marks(bcols);
+        # pragma omp for schedule(dynamic, 16)
+        for (long long b = 0; b < brows; b += step) {
+            long long row_end = (b + 1) * r < rows ? (b + 1) * r : rows;
+            blocks += count_brow_blocks(mtx_csr, b, r, c, mark, NULL);
+            nnz += mtx_csr->row_ptr[row_end] - mtx_csr->row_ptr[b * r];
+        }
+        free(mark);
+    }
+
+    return nnz > 0 ? (double) blocks * r * c / nnz : 1.0;
+}
+
+double bcsr_choose_block(struct sparse_matrix_csr *mtx_csr, int *r, int *c, int thread_count) {
+    const int sizes[2 * BCSR_NUM_BLOCK_SIZES] = BCSR_BLOCK_SIZES;
+    double best_cost = 0, best_fill = 1;
+    *r = 1;
+    *c = 1;
+    for (int s = 0; s < BCSR_NUM_BLOCK_SIZES; s++) {
+        int rs = sizes[2*s], cs = sizes[2*s + 1];
+        double fill = rs * cs == 1 ? 1.0 : bcsr_estimate_fill(mtx_csr, rs, cs, BCSR_SAMPLE_FRACTION, thread_count);
+        double cost = fill * (sizeof(value_t) + (double) sizeof(int) / (rs * cs)); /* bytes per non-zero */
+        if (s == 0 || cost < best_cost) {
+            best_cost = cost;
+            best_fill = fill;
+            *r = rs;
+            *c = cs;
+        }
+    }
+    return best_fill;
+}
+
+void free_bcsr_matrix(struct sparse_matrix_bcsr *mtx_bcsr) {
+    free(mtx_bcsr->brow_ptr);
+    free(mtx_bcsr->bcol);
+    free(mtx_bcsr->values);
+    *mtx_bcsr = init_bcsr_matrix();
+}
@@ -11,12 +11,14 @@ struct sparse_matrix_csr init_csr_matrix(void) {
         .rows       = 0, 
         .values     = NULL, 
         .col_index  = NULL, 
-        .row_ptr    = NULL
+        .row_ptr    = NULL,
+        .row_part   = NULL,
+        .merge_part = NULL
     };
     return m;
 }
 
-int build_csr_matrix(int **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz){
+int build_csr_matrix(value_t **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz){
     struct sparse_matrix_csr *csr = output_mtx_csr;
     // long long nnz = count_nnz(input_mtx, rows, cols); /* Use this function to not require nnz input by user. Will take more time though. */
     csr->rows = rows;
@@ -25,9 +27,9 @@ int build_csr_matrix(int **input_mtx, struct sparse_matrix_csr *output_mtx_csr,
      */
     csr->row_ptr   = malloc( (rows+1) * sizeof(long long));
     csr->col_index = malloc( nnz * sizeof(long long));
-    csr->values    = malloc( nnz * sizeof(int));
+    csr->values    = malloc( nnz * sizeof(value_t));
 
-    int val;
+    value_t val;
     long long idx = 0;
     csr->row_ptr[0] = 0;
 
@@ -54,7 +56,7 @@ int build_csr_matrix(int **input_mtx, struct sparse_matrix_csr *output_mtx_csr,
     }
 };
 
-int build_csr_matrix_parallel(int **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz, size_t thread_count){
+int build_csr_matrix_parallel(value_t **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, long long nnz, size_t thread_count){
     struct sparse_matrix_csr *csr = output_mtx_csr;
     // long long nnz = count_nnz(input_mtx, rows, cols); /* Use this function to not require nnz input by user. Will take more time though. */
     csr->rows = rows;
@@ -63,14 +65,14 @@ int build_csr_matrix_parallel(int **input_mtx, struct sparse_matrix_csr *output_
      */
     csr->row_ptr   = malloc( (rows+1) * sizeof(long long));
     csr->col_index = malloc( nnz * sizeof(long long));
-    csr->values    = malloc( nnz * sizeof(int));
+    csr->values    = malloc( nnz * sizeof(value_t));
     csr->row_ptr[0] = 0;
 
     /* Local variables of each thread */
-    int my_val;
+    value_t my_val;
     long long my_col, my_idx = 0, my_row_idx = 0;
     /* Local arrays of each thread. */
-    int *val_local;
+    value_t *val_local;
     long long *col_local, *row_local;
     long long **row_locals = calloc(thread_count, sizeof(*row_local));
     long long *our_rows = calloc(thread_count, sizeof(long long));
@@ -99,7 +101,7 @@ int build_csr_matrix_parallel(int **input_mtx, struct sparse_matrix_csr *output_
 
         /* Each thread allocates its private array */
         /* Need to allocate nnz elements for the worst case */
-        val_local = calloc(nnz, sizeof(int)); /* Initialize values to 0 so that we may find where each thread's subarray should end. */
+        val_local = calloc(nnz, sizeof(value_t)); /* Initialize values to 0 so that we may find where each thread's subarray should end. */
         col_local = malloc(nnz * sizeof(long long));
         // long long rows_per_thread = (rows+1)/final_thread_count;
         row_local = malloc((my_rows+1) * sizeof(long long));
@@ -197,7 +199,196 @@ int build_csr_matrix_parallel(int **input_mtx, struct sparse_matrix_csr *output_
     }
 }
 
+int build_csr_matrix_two_pass(value_t **input_mtx, struct sparse_matrix_csr *output_mtx_csr, long long rows, long long cols, size_t thread_count){
+    struct sparse_matrix_csr *csr = output_mtx_csr;
+    csr->rows = rows;
+    csr->row_ptr = malloc( (rows+1) * sizeof(long long));
+    long long *thread_nnz = calloc(thread_count + 1, sizeof(long long)); /* non-zeros of each thread's rows, then offsets */
+    if (!csr->row_ptr || !thread_nnz) {
+        free(csr->row_ptr);
+        csr->row_ptr = NULL;
+        free(thread_nnz);
+        return 0;
+    }
+    long long *row_ptr = csr->row_ptr;
+    row_ptr[0] = 0;
+    int ok = 1;
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        #ifdef _OPENMP
+        int tid = omp_get_thread_num();
+        #else
+        int tid = 0;
+        #endif
+
+        /* Pass 1: row_ptr[i+1] = non-zeros of row i. The static schedule gives every thread the same rows in
+         * both passes, so each thread rescans rows it already brought in cache and writes its own part of the arrays. */
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < rows; i++) {
+            const value_t *row = input_mtx[i];
+            long long count = 0;
+            # pragma omp simd reduction(+:count)
+            for (long long j = 0; j < cols; j++)
+                count += row[j] != 0;
+            row_ptr[i+1] = count;
+        }
+
+        /* Exclusive scan: each thread scans its rows, the thread totals are scanned, then added back */
+        long long my_start = -1, my_end = -1, sum = 0;
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < rows; i++) {
+            if (my_start < 0) my_start = i;
+            my_end = i + 1;
+            sum += row_ptr[i+1];
+            row_ptr[i+1] = sum;
+        }
+        thread_nnz[tid + 1] = sum;
+        # pragma omp barrier
+
+        # pragma omp single
+        {
+            for (size_t t = 0; t < thread_count; t++)
+                thread_nnz[t+1] += thread_nnz[t];
+            long long nnz = thread_nnz[thread_count];
+            csr->col_index = malloc( nnz * sizeof(long long));
+            csr->values    = malloc( nnz * sizeof(value_t));
+            if ((!csr->col_index || !csr->values) && nnz > 0) ok = 0;
+        } /* Implicit barrier */
+
+        if (my_start >= 0) {
+            long long offset = thread_nnz[tid];
+            for (long long i = my_start; i < my_end; i++)
+                row_ptr[i+1] += offset;
+        }
+        # pragma omp barrier
+
+        /* Pass 2: each row is written from its final offset, no combine step */
+        if (ok) {
+            # pragma omp for schedule(static)
+            for (long long i = 0; i < rows; i++) {
+                const value_t *row = input_mtx[i];
+                long long idx = row_ptr[i];
+                for (long long j = 0; j < cols; j++) {
+                    value_t val = row[j];
+                    if (val) {
+                        csr->values[idx] = val;
+                        csr->col_index[idx] = j;
+                        idx++;
+                    }
+                }
+            }
+        }
+    }
+
+    free(thread_nnz);
+    if (!ok) { /* no partial matrix is left behind */
+        free(csr->row_ptr);
+        free(csr->col_index);
+        free(csr->values);
+        csr->row_ptr = NULL;
+        csr->col_index = NULL;
+        csr->values = NULL;
+    }
+    return ok;
+}
+
+static struct csr_partition *alloc_partition(int nparts, int merge) {
+    struct csr_partition *part = malloc(sizeof(*part));
+    if (!part) {
+        perror("malloc partition");
+        exit(EXIT_FAILURE);
+    }
+    part->nparts = nparts;
+    part->row_start = malloc((nparts + 1) * sizeof(long long));
+    part->nz_start = merge ? malloc((nparts + 1) * sizeof(long long)) : NULL;
+    if (!part->row_start || (merge && !part->nz_start)) {
+        perror("malloc partition");
+        exit(EXIT_FAILURE);
+    }
+    return part;
+}
+
+static void free_partition(struct csr_partition *part) {
+    if (!part) return;
+    free(part->row_start);
+    free(part->nz_start);
+    free(part);
+}
+
+const struct csr_partition *csr_row_partition(struct sparse_matrix_csr *mtx_csr, int nparts) {
+    if (nparts < 1) nparts = 1;
+    if (mtx_csr->row_part && mtx_csr->row_part->nparts == nparts)
+        return mtx_csr->row_part;
+    free_partition(mtx_csr->row_part);
+
+    struct csr_partition *part = alloc_partition(nparts, 0);
+    long long rows = mtx_csr->rows;
+    const long long *row_ptr = mtx_csr->row_ptr;
+    long long total = row_ptr[rows] + rows; /* work of a row: its non-zeros, plus one for the row itself */
+
+    part->row_start[0] = 0;
+    for (int p = 1; p < nparts; p++) {
+        /* First row i whose prefix work row_ptr[i] + i reaches p/nparts of the total */
+        long long target = total / nparts * p + total % nparts * p / nparts;
+        long long lo = part->row_start[p-1], hi = rows;
+        while (lo < hi) {
+            long long mid = lo + (hi - lo) / 2;
+            if (row_ptr[mid] + mid < target)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        part->row_start[p] = lo;
+    }
+    part->row_start[nparts] = rows;
+
+    mtx_csr->row_part = part;
+    return part;
+}
+
+const struct csr_partition *csr_merge_partition(struct sparse_matrix_csr *mtx_csr, int nparts) {
+    if (nparts < 1) nparts = 1;
+    if (mtx_csr->merge_part && mtx_csr->merge_part->nparts == nparts)
+        return mtx_csr->merge_part;
+    free_partition(mtx_csr->merge_part);
+
+    struct csr_partition *part = alloc_partition(nparts, 1);
+    long long rows = mtx_csr->rows;
+    long long nnz = mtx_csr->row_ptr[rows];
+    const long long *row_end = &mtx_csr->row_ptr[1]; /* row_end[i]: one past the last non-zero of row i */
+    long long path = rows + nnz;
+
+    for (int p = 0; p <= nparts; p++) {
+        /* Point of the merge path on diagonal d: i rows completed and d - i non-zeros consumed,
+         * with i the smallest value such that row i ends after non-zero d - i - 1 */
+        long long d = path / nparts * p + path % nparts * p / nparts;
+        long long lo = d > nnz ? d - nnz : 0;
+        long long hi = d < rows ? d : rows;
+        while (lo < hi) {
+            long long mid = lo + (hi - lo) / 2;
+            if (row_end[mid] <= d - mid - 1)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        part->row_start[p] = lo;
+        part->nz_start[p] = d - lo;
+    }
+
+    mtx_csr->merge_part = part;
+    return part;
+}
+
+void free_csr_caches(struct sparse_matrix_csr *mtx_csr){
+    free_partition(mtx_csr->row_part);
+    free_partition(mtx_csr->merge_part);
+    mtx_csr->row_part = NULL;
+    mtx_csr->merge_part = NULL;
+}
+
 void free_csr_matrix(struct sparse_matrix_csr *mtx_csr){
+    free_csr_caches(mtx_csr);
     free(mtx_csr->values);
     free(mtx_csr->col_index);
     free(mtx_csr->row_ptr);
@@ -206,9 +397,9 @@ void free_csr_matrix(struct sparse_matrix_csr *mtx_csr){
     return;
 }
 
-long long count_nnz(int **mtx, long long rows, long long cols){
+long long count_nnz(value_t **mtx, long long rows, long long cols){
     long long i, j, nnz = 0;
-    int val;
+    value_t val;
 
     for(i = 0; i < rows; i++){
         for(j = 0; j < cols; j++){
@@ -249,7 +440,7 @@ void print_csr_matrix(struct sparse_matrix_csr *M, long long nnz){
     if (M->values != NULL){
         printf("  values  = [");
         for (long long i = 0; i < nnz; i++){
-            printf("%d, ", M->values[i]);
+            printf(VEC_FMT ", ", (vec_t) M->values[i]);
         }
         printf("]\n");
     }
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sparse_matrix_csr_compact.h"
+
+struct sparse_matrix_csr_compact init_csr_compact_matrix(void) {
+    struct sparse_matrix_csr_compact m = {
+        .rows       = 0,
+        .nnz        = 0,
+        .encoding   = CSR_COMPACT_U32,
+        .values     = NULL,
+        .row_ptr    = NULL,
+        .col_index  = NULL,
+        .row_base   = NULL,
+        .row_width  = NULL,
+        .delta_ptr  = NULL,
+        .deltas     = NULL
+    };
+    return m;
+}
+
+static void *xmalloc(size_t size, const char *what) {
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* Smallest of 1, 2 or 4 bytes holding the largest delta between consecutive columns of a row. 0 if the row is not sorted. */
+static int row_delta_width(const long long *col, long long len) {
+    long long max_delta = 0;
+    for (long long k = 1; k < len; k++) {
+        long long d = col[k] - col[k-1];
+        if (d < 0) return 0;
+        if (d > max_delta) max_delta = d;
+    }
+    if (max_delta <= UINT8_MAX)  return 1;
+    if (max_delta <= UINT16_MAX) return 2;
+    return 4;
+}
+
+int build_csr_compact_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_csr_compact *output_mtx, enum csr_compact_encoding encoding, int thread_count) {
+    struct sparse_matrix_csr_compact *cm = output_mtx;
+    long long rows = mtx_csr->rows;
+    long long nnz = mtx_csr->row_ptr[rows];
+    const long long *row_ptr = mtx_csr->row_ptr;
+    const long long *col = mtx_csr->col_index;
+
+    if (rows > UINT32_MAX) return 0; /* square matrix: the columns must fit 32 bits */
+    if (thread_count < 1) thread_count = 1;
+
+    *cm = init_csr_compact_matrix();
+    cm->rows = rows;
+    cm->nnz = nnz;
+    cm->encoding = encoding;
+    cm->values  = xmalloc(nnz * sizeof(value_t), "malloc values");
+    cm->row_ptr = xmalloc((rows + 1) * sizeof(long long), "malloc row_ptr");
+    memcpy(cm->values, mtx_csr->values, nnz * sizeof(value_t));
+    memcpy(cm->row_ptr, row_ptr, (rows + 1) * sizeof(long long));
+
+    if (encoding == CSR_COMPACT_U32) {
+        cm->col_index = xmalloc(nnz * sizeof(uint32_t), "malloc col_index");
+        # pragma omp parallel for num_threads(thread_count) schedule(static)
+        for (long long j = 0; j < nnz; j++) {
+            cm->col_index[j] = (uint32_t) col[j];
+        }
+        return 1;
+    }
+
+    cm->row_base  = xmalloc(rows * sizeof(uint32_t), "malloc row_base");
+    cm->row_width = xmalloc(rows * sizeof(uint8_t), "malloc row_width");
+    cm->delta_ptr = xmalloc((rows + 1) * sizeof(long long), "malloc delta_ptr");
+    int sorted = 1;
+
+    /* Pass 1: width of every row, and its size in bytes (in delta_ptr[i+1], turned into offsets below) */
+    # pragma omp parallel for num_threads(thread_count) schedule(static) reduction(&&:sorted)
+    for (long long i = 0; i < rows; i++) {
+        long long len = row_ptr[i+1] - row_ptr[i];
+        int width = row_delta_width(&col[row_ptr[i]], len);
+        if (width == 0) {
+            sorted = 0;
+            width = 4;
+        }
+        cm->row_width[i] = (uint8_t) width;
+        cm->row_base[i] = len > 0 ? (uint32_t) col[row_ptr[i]] : 0;
+        cm->delta_ptr[i+1] = len > 0 ? (len - 1) * width : 0;
+    }
+    if (!sorted) {
+        free_csr_compact_matrix(cm);
+        return 0;
+    }
+
+    cm->delta_ptr[0] = 0;
+    for (long long i = 0; i < rows; i++) {
+        cm->delta_ptr[i+1] += cm->delta_ptr[i];
+    }
+    cm->deltas = xmalloc(cm->delta_ptr[rows], "malloc deltas");
+
+    /* Pass 2: deltas, little-endian */
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long long i = 0; i < rows; i++) {
+        int width = cm->row_width[i];
+        uint8_t *dst = &cm->deltas[cm->delta_ptr[i]];
+        for (long long j = row_ptr[i] + 1; j < row_ptr[i+1]; j++) {
+            uint32_t d = (uint32_t) (col[j] - col[j-1]);
+            memcpy(dst, &d, width);
+            dst += width;
+        }
+    }
+
+    return 1;
+}
+
+long long csr_compact_index_bytes(const struct sparse_matrix_csr_compact *mtx) {
+    if (mtx->encoding == CSR_COMPACT_U32) {
+        return mtx->nnz * (long long) sizeof(uint32_t);
+    }
+    return mtx->delta_ptr[mtx->rows]
+         + mtx->rows * (long long) (sizeof(uint32_t) + sizeof(uint8_t) + sizeof(long long));
+}
+
+void free_csr_compact_matrix(struct sparse_matrix_csr_compact *mtx) {
+    free(mtx->values);
+    free(mtx->row_ptr);
+    free(mtx->col_index);
+    free(mtx->row_base);
+    free(mtx->row_width);
+    free(mtx->delta_ptr);
+    free(mtx->deltas);
+    *mtx = init_csr_compact_matrix();
+}
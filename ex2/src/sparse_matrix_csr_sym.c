@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sparse_matrix_csr_sym.h"
+
+struct sparse_matrix_csr_sym init_csr_sym_matrix(void) {
+    struct sparse_matrix_csr_sym m = {
+        .rows         = 0,
+        .nnz          = 0,
+        .values       = NULL,
+        .col_index    = NULL,
+        .row_ptr      = NULL,
+        .nparts       = 0,
+        .part_start   = NULL,
+        .part_col_end = NULL
+    };
+    return m;
+}
+
+static void *xmalloc(size_t size, const char *what) {
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        perror(what);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+/* Position of column COL in the sorted columns [lo, hi) of a row, or -1 */
+static long long find_col(const long long *col_index, long long lo, long long hi, long long col) {
+    long long end = hi;
+    while (lo < hi) {
+        long long mid = lo + (hi - lo) / 2;
+        if (col_index[mid] < col)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < end && col_index[lo] == col ? lo : -1;
+}
+
+int build_csr_sym_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_csr_sym *output_mtx, int check, int thread_count) {
+    long long rows = mtx_csr->rows;
+    const long long *row_ptr = mtx_csr->row_ptr;
+    const long long *col = mtx_csr->col_index;
+    const value_t *val = mtx_csr->values;
+    if (thread_count < 1) thread_count = 1;
+
+    /* Every element below the diagonal must have its mirror above it, with the same value. With as many elements
+     * below as above, the two triangles then match one to one. */
+    if (check) {
+        long long lower = 0, upper = 0;
+        int symmetric = 1;
+        # pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1024) reduction(+:lower, upper) reduction(&&:symmetric)
+        for (long long i = 0; i < rows; i++) {
+            for (long long k = row_ptr[i]; k < row_ptr[i+1]; k++) {
+                long long j = col[k];
+                if (j > i) {
+                    upper++;
+                } else if (j < i) {
+                    lower++;
+                    long long m = find_col(col, row_ptr[j], row_ptr[j+1], i);
+                    if (m < 0 || val[m] != val[k]) symmetric = 0;
+                }
+            }
+        }
+        if (!symmetric || lower != upper) return 0;
+    }
+
+    struct sparse_matrix_csr_sym *sm = output_mtx;
+    *sm = init_csr_sym_matrix();
+    sm->rows = rows;
+    sm->row_ptr = xmalloc((rows + 1) * sizeof(long long), "malloc row_ptr");
+
+    /* Pass 1: stored elements per row (the row's columns >= i, a suffix of the sorted row), and the full non-zeros */
+    long long full = 0;
+    # pragma omp parallel for num_threads(thread_count) schedule(static) reduction(+:full)
+    for (long long i = 0; i < rows; i++) {
+        long long k = row_ptr[i];
+        while (k < row_ptr[i+1] && col[k] < i) k++;
+        long long count = row_ptr[i+1] - k;
+        sm->row_ptr[i+1] = count;
+        full += 2 * count - (count > 0 && col[k] == i);
+    }
+    sm->row_ptr[0] = 0;
+    for (long long i = 0; i < rows; i++)
+        sm->row_ptr[i+1] += sm->row_ptr[i];
+    sm->nnz = full;
+
+    long long stored = sm->row_ptr[rows];
+    sm->col_index = xmalloc(stored * sizeof(long long), "malloc col_index");
+    sm->values    = xmalloc(stored * sizeof(value_t), "malloc values");
+
+    /* Pass 2: copy the suffixes */
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long long i = 0; i < rows; i++) {
+        long long k = row_ptr[i+1] - (sm->row_ptr[i+1] - sm->row_ptr[i]);
+        for (long long d = sm->row_ptr[i]; d < sm->row_ptr[i+1]; d++, k++) {
+            sm->col_index[d] = col[k];
+            sm->values[d] = val[k];
+        }
+    }
+
+    return 1;
+}
+
+void expand_csr_sym_matrix(const struct sparse_matrix_csr_sym *mtx, struct sparse_matrix_csr *output_mtx_csr) {
+    struct sparse_matrix_csr *csr = output_mtx_csr;
+    long long rows = mtx->rows;
+    csr->rows = rows;
+    csr->row_ptr   = xmalloc((rows + 1) * sizeof(long long), "malloc row_ptr");
+    csr->col_index = xmalloc(mtx->nnz * sizeof(long long), "malloc col_index");
+    csr->values    = xmalloc(mtx->nnz * sizeof(value_t), "malloc values");
+
+    /* Row i holds its mirrored elements (from rows k < i) then its stored ones */
+    for (long long i = 0; i <= rows; i++)
+        csr->row_ptr[i] = 0;
+    for (long long i = 0; i < rows; i++) {
+        csr->row_ptr[i+1] += mtx->row_ptr[i+1] - mtx->row_ptr[i];
+        for (long long k = mtx->row_ptr[i]; k < mtx->row_ptr[i+1]; k++) {
+            if (mtx->col_index[k] != i) csr->row_ptr[mtx->col_index[k] + 1]++;
+        }
+    }
+    for (long long i = 0; i < rows; i++)
+        csr->row_ptr[i+1] += csr->row_ptr[i];
+
+    long long *fill = xmalloc((rows > 0 ? rows : 1) * sizeof(long long), "malloc fill");
+    for (long long i = 0; i < rows; i++)
+        fill[i] = csr->row_ptr[i];
+    /* Rows in increasing order: the mirrored elements of each row arrive sorted, and all before its stored ones */
+    for (long long i = 0; i < rows; i++) {
+        for (long long k = mtx->row_ptr[i]; k < mtx->row_ptr[i+1]; k++) {
+            long long j = mtx->col_index[k];
+            if (j != i) {
+                csr->col_index[fill[j]] = i;
+                csr->values[fill[j]++] = mtx->values[k];
+            }
+        }
+        for (long long k = mtx->row_ptr[i]; k < mtx->row_ptr[i+1]; k++) {
+            csr->col_index[fill[i]] = mtx->col_index[k];
+            csr->values[fill[i]++] = mtx->values[k];
+        }
+    }
+    free(fill);
+}
+
+int csr_sym_partition(struct sparse_matrix_csr_sym *mtx, int nparts) {
+    if (nparts < 1) nparts = 1;
+    if (mtx->part_start && mtx->nparts == nparts)
+        return nparts;
+    free(mtx->part_start);
+    free(mtx->part_col_end);
+
+    long long rows = mtx->rows;
+    const long long *row_ptr = mtx->row_ptr;
+    long long total = row_ptr[rows] + rows; /* work of a row: its stored elements, plus one for the row itself */
+    mtx->part_start   = xmalloc((nparts + 1) * sizeof(long long), "malloc part_start");
+    mtx->part_col_end = xmalloc(nparts * sizeof(long long), "malloc part_col_end");
+
+    mtx->part_start[0] = 0;
+    for (int p = 1; p < nparts; p++) {
+        long long target = total / nparts * p + total % nparts * p / nparts;
+        long long lo = mtx->part_start[p-1], hi = rows;
+        while (lo < hi) {
+            long long mid = lo + (hi - lo) / 2;
+            if (row_ptr[mid] + mid < target)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        mtx->part_start[p] = lo;
+    }
+    mtx->part_start[nparts] = rows;
+
+    /* The last column of a sorted row is its largest */
+    for (int p = 0; p < nparts; p++) {
+        long long end = mtx->part_start[p+1];
+        for (long long i = mtx->part_start[p]; i < mtx->part_start[p+1]; i++) {
+            if (row_ptr[i+1] > row_ptr[i] && mtx->col_index[row_ptr[i+1] - 1] + 1 > end)
+                end = mtx->col_index[row_ptr[i+1] - 1] + 1;
+        }
+        mtx->part_col_end[p] = end;
+    }
+
+    mtx->nparts = nparts;
+    return nparts;
+}
+
+void free_csr_sym_matrix(struct sparse_matrix_csr_sym *mtx) {
+    free(mtx->values);
+    free(mtx->col_index);
+    free(mtx->row_ptr);
+    free(mtx->part_start);
+    free(mtx->part_col_end);
+    *mtx = init_csr_sym_matrix();
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "sparse_matrix_sell.h"
+
+struct sparse_matrix_sell init_sell_matrix(void) {
+    struct sparse_matrix_sell m = {
+        .rows       = 0,
+        .C          = 0,
+        .sigma      = 0,
+        .nslices    = 0,
+        .nnz        = 0,
+        .slice_ptr  = NULL,
+        .values     = NULL,
+        .col_index  = NULL,
+        .perm       = NULL
+    };
+    return m;
+}
+
+/* A row and its number of non-zeros, sorted inside a sigma window */
+struct row_len {
+    long long row;
+    long long len;
+};
+
+static int cmp_len_desc(const void *a, const void *b) {
+    const struct row_len *ra = a, *rb = b;
+    if (ra->len != rb->len) return ra->len < rb->len ? 1 : -1;
+    return (ra->row > rb->row) - (ra->row < rb->row); /* keep the original order of rows of equal length */
+}
+
+int build_sell_matrix(struct sparse_matrix_csr *mtx_csr, struct sparse_matrix_sell *output_mtx_sell, int C, int sigma, int thread_count) {
+    struct sparse_matrix_sell *sell = output_mtx_sell;
+    long long rows = mtx_csr->rows;
+    const long long *row_ptr = mtx_csr->row_ptr;
+
+    if (C < 1 || C > SELL_MAX_C) return 0;
+    if (rows > INT32_MAX) return 0; /* square matrix: the column indices must fit 32 bits */
+    if (thread_count < 1) thread_count = 1;
+
+    long long nslices = (rows + C - 1) / C;
+    long long padded_rows = nslices * C;
+    /* Whole slices per window, computed in long long: any SIGMA >= rows is one global window */
+    long long window = sigma < C ? C : sigma;
+    if (window > padded_rows) window = padded_rows > 0 ? padded_rows : C;
+    window = (window + C - 1) / C * C;
+    sell->rows = rows;
+    sell->C = C;
+    sell->sigma = window;
+    sell->nslices = nslices;
+    sell->nnz = row_ptr[rows];
+    sell->perm = malloc(padded_rows * sizeof(long long));
+    sell->slice_ptr = malloc((nslices + 1) * sizeof(long long));
+    struct row_len *order = malloc(padded_rows * sizeof(struct row_len));
+    if (!sell->perm || !sell->slice_ptr || !order) {
+        perror("malloc sell");
+        exit(EXIT_FAILURE);
+    }
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Sort the rows of every window by decreasing length, so that the rows of a slice have similar lengths */
+        # pragma omp for schedule(dynamic, 1)
+        for (long long w0 = 0; w0 < rows; w0 += window) {
+            long long w1 = w0 + window < rows ? w0 + window : rows;
+            for (long long i = w0; i < w1; i++) {
+                order[i].row = i;
+                order[i].len = row_ptr[i+1] - row_ptr[i];
+            }
+            qsort(&order[w0], w1 - w0, sizeof(struct row_len), cmp_len_desc);
+        } /* implicit barrier */
+
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < padded_rows; i++) {
+            if (i >= rows) { /* padding rows of the last slice */
+                order[i].row = -1;
+                order[i].len = 0;
+            }
+            sell->perm[i] = order[i].row;
+        } /* implicit barrier */
+
+        /* Slice sizes: C times the longest row of the slice */
+        # pragma omp for schedule(static)
+        for (long long s = 0; s < nslices; s++) {
+            long long width = 0;
+            for (int l = 0; l < C; l++) {
+                if (order[s*C + l].len > width) width = order[s*C + l].len;
+            }
+            sell->slice_ptr[s+1] = width * C;
+        } /* implicit barrier */
+
+        # pragma omp single
+        {
+            sell->slice_ptr[0] = 0;
+            for (long long s = 0; s < nslices; s++) {
+                sell->slice_ptr[s+1] += sell->slice_ptr[s];
+            }
+            long long size = sell->slice_ptr[nslices];
+            sell->values    = malloc((size > 0 ? size : 1) * sizeof(value_t));
+            sell->col_index = malloc((size > 0 ? size : 1) * sizeof(int));
+            if (!sell->values || !sell->col_index) {
+                perror("malloc sell arrays");
+                exit(EXIT_FAILURE);
+            }
+        } /* implicit barrier */
+
+        /* Fill the slices column-major, padding the short rows */
+        # pragma omp for schedule(dynamic, 64)
+        for (long long s = 0; s < nslices; s++) {
+            long long off = sell->slice_ptr[s];
+            long long width = (sell->slice_ptr[s+1] - off) / C;
+            for (int l = 0; l < C; l++) {
+                long long row = order[s*C + l].row;
+                long long start = row >= 0 ? row_ptr[row] : 0;
+                long long len = order[s*C + l].len;
+                for (long long k = 0; k < width; k++) {
+                    long long dst = off + k*C + l;
+                    if (k < len) {
+                        sell->values[dst]    = mtx_csr->values[start + k];
+                        sell->col_index[dst] = (int) mtx_csr->col_index[start + k];
+                    } else {
+                        sell->values[dst]    = 0;
+                        sell->col_index[dst] = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    free(order);
+    return 1;
+}
+
+void free_sell_matrix(struct sparse_matrix_sell *mtx_sell) {
+    free(mtx_sell->slice_ptr);
+    free(mtx_sell->values);
+    free(mtx_sell->col_index);
+    free(mtx_sell->perm);
+    *mtx_sell = init_sell_matrix();
+}
@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "value_type.h"
+
+/* The vector kernels are int32 only */
+#if (defined(__x86_64__) || defined(__i386__)) && VALUE_IS_INT
+#define SPMM_CSR_X86
+#include <immintrin.h>
+#endif
+
+#include "spmm_csr.h"
+#include "sparse_matrix_csr.h"
+
+/* Row i of Y = A X for K interleaved vectors */
+typedef void (*spmm_row_fn)(const struct sparse_matrix_csr *A, long long i, const vec_t *X, vec_t *Y, int k);
+
+/* Lanes [l0, k) of row i, one lane at a time (each sum in a register, the row re-read from L1 for every lane) */
+static inline void row_lanes(const struct sparse_matrix_csr *A, long long i, const vec_t *X, vec_t *y, int k, int l0) {
+    for (int l = l0; l < k; l++) {
+        vec_t sum = 0;
+        for (long long j = A->row_ptr[i]; j < A->row_ptr[i+1]; j++) {
+            sum += A->values[j] * X[A->col_index[j] * k + l];
+        }
+        y[l] = sum;
+    }
+}
+
+static void row_scalar(const struct sparse_matrix_csr *A, long long i, const vec_t *X, vec_t *Y, int k) {
+    row_lanes(A, i, X, &Y[i * k], k, 0);
+}
+
+#ifdef SPMM_CSR_X86
+/* Lanes [l, l + 8*NV) of row i: NV registers of sums, kept for the whole row. Inlined with a constant NV. */
+__attribute__((target("avx2"), always_inline))
+static inline void pass_avx2(const struct sparse_matrix_csr *A, long long i, const int *X, int *y, int k, int l, int nv) {
+    __m256i acc[4];
+    for (int v = 0; v < nv; v++) acc[v] = _mm256_setzero_si256();
+    for (long long j = A->row_ptr[i]; j < A->row_ptr[i+1]; j++) {
+        __m256i a = _mm256_set1_epi32(A->values[j]);
+        const int *x = &X[A->col_index[j] * k + l];
+        for (int v = 0; v < nv; v++)
+            acc[v] = _mm256_add_epi32(acc[v], _mm256_mullo_epi32(a, _mm256_loadu_si256((const __m256i *) &x[8*v])));
+    }
+    for (int v = 0; v < nv; v++) _mm256_storeu_si256((__m256i *) &y[l + 8*v], acc[v]);
+}
+
+__attribute__((target("avx512f"), always_inline))
+static inline void pass_avx512(const struct sparse_matrix_csr *A, long long i, const int *X, int *y, int k, int l, int nv) {
+    __m512i acc[4];
+    for (int v = 0; v < nv; v++) acc[v] = _mm512_setzero_si512();
+    for (long long j = A->row_ptr[i]; j < A->row_ptr[i+1]; j++) {
+        __m512i a = _mm512_set1_epi32(A->values[j]);
+        const int *x = &X[A->col_index[j] * k + l];
+        for (int v = 0; v < nv; v++)
+            acc[v] = _mm512_add_epi32(acc[v], _mm512_mullo_epi32(a, _mm512_loadu_si512((const void *) &x[16*v])));
+    }
+    for (int v = 0; v < nv; v++) _mm512_storeu_si512((void *) &y[l + 16*v], acc[v]);
+}
+
+/* Last K - L < 16 lanes, with masked loads and stores */
+__attribute__((target("avx512f")))
+static void pass_avx512_tail(const struct sparse_matrix_csr *A, long long i, const int *X, int *y, int k, int l) {
+    __mmask16 m = (__mmask16) ((1u << (k - l)) - 1);
+    __m512i acc = _mm512_setzero_si512();
+    for (long long j = A->row_ptr[i]; j < A->row_ptr[i+1]; j++) {
+        __m512i a = _mm512_set1_epi32(A->values[j]);
+        __m512i x = _mm512_maskz_loadu_epi32(m, &X[A->col_index[j] * k + l]);
+        acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(a, x));
+    }
+    _mm512_mask_storeu_epi32(&y[l], m, acc);
+}
+
+/* Up to 32 lanes per pass over the row, the rest 8 by 8 then one by one */
+__attribute__((target("avx2")))
+static void row_avx2(const struct sparse_matrix_csr *A, long long i, const int *X, int *Y, int k) {
+    int *y = &Y[i * k];
+    int l = 0;
+    for (; l + 32 <= k; l += 32) pass_avx2(A, i, X, y, k, l, 4);
+    for (; l + 8 <= k; l += 8) pass_avx2(A, i, X, y, k, l, 1);
+    if (l < k) row_lanes(A, i, X, y, k, l);
+}
+
+/* Up to 64 lanes per pass over the row, then 32, 16, 8, and the rest masked (or one by one for a single lane,
+ * which keeps the scalar speed for a single vector) */
+__attribute__((target("avx512f")))
+static void row_avx512(const struct sparse_matrix_csr *A, long long i, const int *X, int *Y, int k) {
+    int *y = &Y[i * k];
+    int l = 0;
+    for (; l + 64 <= k; l += 64) pass_avx512(A, i, X, y, k, l, 4);
+    if (l + 32 <= k) {
+        pass_avx512(A, i, X, y, k, l, 2);
+        l += 32;
+    }
+    if (l + 16 <= k) {
+        pass_avx512(A, i, X, y, k, l, 1);
+        l += 16;
+    }
+    if (l + 8 <= k) {
+        pass_avx2(A, i, X, y, k, l, 1);
+        l += 8;
+    }
+    if (k - l > 1) {
+        pass_avx512_tail(A, i, X, y, k, l);
+    } else if (l < k) {
+        row_lanes(A, i, X, y, k, l);
+    }
+}
+#endif
+
+/* Runtime CPU dispatch */
+static spmm_row_fn select_row(const char **isa) {
+    #ifdef SPMM_CSR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        if (isa) *isa = "avx512";
+        return row_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        if (isa) *isa = "avx2";
+        return row_avx2;
+    }
+    #endif
+    if (isa) *isa = "scalar";
+    return row_scalar;
+}
+
+const char *spmm_csr_isa(void) {
+    const char *isa;
+    select_row(&isa);
+    return isa;
+}
+
+void spmm_csr(struct sparse_matrix_csr *A_csr, const vec_t *X, vec_t *Y, int k) {
+    spmm_row_fn row = select_row(NULL);
+    for (long long i = 0; i < A_csr->rows; i++) {
+        row(A_csr, i, X, Y, k);
+    }
+}
+
+void spmm_csr_parallel(struct sparse_matrix_csr *A_csr, const vec_t *X, vec_t *Y, int k, int thread_count) {
+    spmm_row_fn row = select_row(NULL);
+    # pragma omp parallel for num_threads(thread_count) schedule(static)
+    for (long long i = 0; i < A_csr->rows; i++) {
+        row(A_csr, i, X, Y, k);
+    }
+}
+
+void matmuls_csr(struct sparse_matrix_csr *A_csr, vec_t *X, vec_t *res, int k, int iters) {
+    long long size = A_csr->rows * k; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vectors to output vectors. */
+        memcpy(res, X, size * sizeof(vec_t));
+        return;
+    }
+
+    spmm_row_fn row = select_row(NULL);
+
+    /* Two intermediate result blocks, switched at every iteration (as in matvecs_csr) */
+    vec_t **x_tmp = malloc(2 * sizeof(vec_t*));
+    x_tmp[0] = malloc(2 * size * sizeof(vec_t));
+    x_tmp[1] = &x_tmp[0][size];
+    memcpy(x_tmp[0], X, size * sizeof(vec_t));
+
+    vec_t *x_read = NULL, *x_write = NULL;
+    for (int r = 0; r < iters; r++) {
+        x_read  = x_tmp[     r  % 2];
+        x_write = x_tmp[(r + 1) % 2];
+        for (long long i = 0; i < A_csr->rows; i++) {
+            row(A_csr, i, x_read, x_write, k);
+        }
+    }
+
+    /* Copy result to output memory */
+    memcpy(res, x_write, size * sizeof(vec_t));
+
+    /* Free allocated memory */
+    free(x_tmp[0]);
+    free(x_tmp);
+
+    return;
+}
+
+void matmuls_csr_parallel(struct sparse_matrix_csr *A_csr, vec_t *X, vec_t *res, int k, int iters, int thread_count) {
+    long long size = A_csr->rows * k; /* cols = rows for square matrix */
+
+    if (iters < 1) {
+        /* Copy input vectors to output vectors. */
+        for (long long i = 0; i < size; i++) {
+            res[i] = X[i];
+        }
+        return;
+    }
+
+    spmm_row_fn row = select_row(NULL);
+
+    vec_t **x_tmp_global = malloc(2 * sizeof(vec_t*));
+    x_tmp_global[0] = malloc(2 * size * sizeof(vec_t)); /* allocate memory for the two blocks and assign them */
+    x_tmp_global[1] = &x_tmp_global[0][size];
+
+    # pragma omp parallel num_threads(thread_count)
+    {
+        /* Copy the input block to the intermediate block (the vectors are k times larger than in matvecs_csr: omp for) */
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < size; i++) {
+            x_tmp_global[0][i] = X[i];
+        }
+
+        vec_t *x_read = NULL, *x_write = NULL;    /* local, temporary pointers */
+
+        for (int r = 0; r < iters; r++) {
+            x_read  = x_tmp_global[     r  % 2];
+            x_write = x_tmp_global[(r + 1) % 2];
+
+            # pragma omp for schedule(static)
+            for (long long i = 0; i < A_csr->rows; i++) {
+                row(A_csr, i, x_read, x_write, k);
+            } /* implicit barrier */
+        }
+
+        /* Copy final result to output memory */
+        # pragma omp for schedule(static)
+        for (long long i = 0; i < size; i++) {
+            res[i] = x_write[i];
+        }
+    }
+
+    /* Free allocated memory */
+    free(x_tmp_global[0]);
+    free(x_tmp_global);
+
+    return;
+}